@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include "multicore_simulator.h"
+
+using bench_clock = std::chrono::steady_clock;
+
+/* Measures how the throughput of multicore_simulator scales with the host
+ * threads, in simulated core cycles per host second. Every core runs the
+ * same loop on words of its own and on a word shared by all the cores:
+ *
+ *   loop: ld    x4, x1, 0      counter of the core
+ *         add   x4, x4, x3
+ *         mulu  x5, x4, x4
+ *         st    x4, x1, 0
+ *         st    x5, x0, 0      shared word, written by every core
+ *         ld    x6, x0, 0
+ *         add   x7, x6, x5
+ *         sub   x2, x2, x3
+ *         bne   x2, x0, loop
+ *
+ * The machine is simulated without a trace with 1, 2, 4, ... host threads,
+ * up to the number of cores, and then with a range of quanta on the most
+ * threads. The best of the repetitions is reported, along with whether
+ * every run ended with the same cycles and memory as the first one.
+ */
+
+static instruction_t make_instruction(const opcode op, const uint32_t dest, const uint32_t op_a, const uint32_t op_b,
+  const operand_t imm = 0) {
+  return instruction_t {op, dest, op_a, op_b, imm};
+}
+
+static decoded_program_t generate_program(const uint32_t core, const uint32_t iterations) {
+  decoded_program_t program {
+    make_instruction(opcode::addi, 1, 0, 0, 64 * (core + 1)),
+    make_instruction(opcode::addi, 2, 0, 0, iterations),
+    make_instruction(opcode::addi, 3, 0, 0, 1),
+    make_instruction(opcode::ld, 4, 1, 0, 0),
+    make_instruction(opcode::add, 4, 4, 3),
+    make_instruction(opcode::mulu, 5, 4, 4),
+    make_instruction(opcode::st, 4, 1, 4, 0),
+    make_instruction(opcode::st, 5, 0, 5, 0),
+    make_instruction(opcode::ld, 6, 0, 0, 0),
+    make_instruction(opcode::add, 7, 6, 5),
+    make_instruction(opcode::sub, 2, 2, 3),
+  };
+  const operand_t offset {static_cast<operand_t>(3) - program.size()};
+  program.push_back(make_instruction(opcode::bne, 2, 2, 0, offset));
+  return program;
+}
+
+struct run_result_t {
+  std::vector<uint64_t> cycles;
+  data_memory memory;
+  double seconds {0};
+};
+
+// simulates every core to completion without a trace
+static run_result_t run(const std::vector<decoded_program_t>& programs, const uint64_t quantum,
+  const uint32_t num_threads) {
+  const auto start {bench_clock::now()};
+  multicore_simulator machine {programs, machine_config {}, quantum, num_threads};
+  while (machine.can_step()) {
+    machine.step_quantum();
+  }
+  run_result_t result;
+  result.seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+  for (size_t i {0}; i < machine.num_cores(); ++i) {
+    result.cycles.push_back(machine.core(i).get_cycle());
+  }
+  result.memory = machine.core(0).get_state().memory;
+  return result;
+}
+
+int main(int argc, char *argv[]) {
+  uint32_t num_cores {8};
+  uint32_t iterations {20000};
+  uint32_t quantum {1000};
+  uint32_t repetitions {3};
+  for (int i {1}; i < argc; ++i) {
+    if (i + 1 < argc && std::strcmp(argv[i], "--cores") == 0) {
+      num_cores = std::max(1ul, std::stoul(argv[++i]));
+    } else if (i + 1 < argc && std::strcmp(argv[i], "--iterations") == 0) {
+      iterations = std::max(1ul, std::stoul(argv[++i]));
+    } else if (i + 1 < argc && std::strcmp(argv[i], "--quantum") == 0) {
+      quantum = std::max(1ul, std::stoul(argv[++i]));
+    } else if (i + 1 < argc && std::strcmp(argv[i], "--repetitions") == 0) {
+      repetitions = std::max(1ul, std::stoul(argv[++i]));
+    } else {
+      std::cerr << "Usage: " << argv[0] << " [--cores <n>] [--iterations <n>] [--quantum <cycles>]"
+                << " [--repetitions <n>]" << std::endl;
+      return 1;
+    }
+  }
+
+  std::vector<decoded_program_t> programs;
+  for (uint32_t core {0}; core < num_cores; ++core) {
+    programs.push_back(generate_program(core, iterations));
+  }
+
+  // the first run is the reference every other run must reproduce
+  const run_result_t reference {run(programs, quantum, 1)};
+  const auto measure = [&](const uint64_t run_quantum, const uint32_t num_threads) {
+    double best_seconds {0};
+    bool deterministic {true};
+    run_result_t result;
+    for (uint32_t repetition {0}; repetition < repetitions; ++repetition) {
+      result = run(programs, run_quantum, num_threads);
+      best_seconds = repetition == 0 ? result.seconds : std::min(best_seconds, result.seconds);
+      if (run_quantum == quantum) {
+        deterministic = deterministic && result.cycles == reference.cycles && result.memory == reference.memory;
+      }
+    }
+    uint64_t total_cycles {0};
+    for (const uint64_t cycles : result.cycles) {
+      total_cycles += cycles;
+    }
+    return std::make_tuple(total_cycles, best_seconds, deterministic);
+  };
+
+  std::cout << num_cores << " cores of " << iterations << " iterations, " << std::thread::hardware_concurrency()
+            << " hardware threads, simulated core Mcycles per host second, best of " << repetitions << '\n';
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << std::setw(8) << "threads" << std::setw(10) << "quantum" << std::setw(12) << "cycles" << std::setw(12)
+            << "Mcycles/s" << std::setw(10) << "speedup" << std::setw(15) << "deterministic" << '\n';
+  double single_thread_seconds {0};
+  uint32_t max_threads {1};
+  for (uint32_t num_threads {1}; num_threads <= num_cores; num_threads *= 2) {
+    const auto [cycles, seconds, deterministic] {measure(quantum, num_threads)};
+    if (num_threads == 1) {
+      single_thread_seconds = seconds;
+    }
+    max_threads = num_threads;
+    std::cout << std::setw(8) << num_threads << std::setw(10) << quantum << std::setw(12) << cycles << std::setw(12)
+              << static_cast<double>(cycles) / seconds / 1e6 << std::setw(10) << single_thread_seconds / seconds
+              << std::setw(15) << (deterministic ? "yes" : "no") << std::endl;
+  }
+
+  // shorter quanta see the stores of the other cores sooner, at the cost of more barriers
+  for (const uint64_t run_quantum : {10, 100, 10000}) {
+    const auto [cycles, seconds, deterministic] {measure(run_quantum, max_threads)};
+    std::cout << std::setw(8) << max_threads << std::setw(10) << run_quantum << std::setw(12) << cycles
+              << std::setw(12) << static_cast<double>(cycles) / seconds / 1e6 << std::setw(10)
+              << single_thread_seconds / seconds << std::setw(15) << "-" << std::endl;
+  }
+  return 0;
+}
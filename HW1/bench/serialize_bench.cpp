@@ -0,0 +1,71 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "json.hpp"
+#include "simulator.h"
+#include "state_serializer.h"
+
+using json = nlohmann::json;
+using bench_clock = std::chrono::steady_clock;
+
+/* Compares the nlohmann DOM serialization of the processor state against the
+ * direct serializer. The program given as input is simulated to completion,
+ * and every cycle's state is serialized with both paths, which must agree.
+ */
+int main(int argc, char *argv[]) {
+  if (argc != 2 && argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <input file> [repetitions]" << std::endl;
+    return 1;
+  }
+
+  std::ifstream input_file(argv[1]);
+  if (!input_file.is_open()) {
+    std::cerr << "Failed to open file: " << argv[1] << std::endl;
+    return 1;
+  }
+  const program_t program = json::parse(input_file);
+  const uint32_t repetitions = argc == 3 ? std::stoul(argv[2]) : 1;
+
+  json_state_serializer serializer;
+  bench_clock::duration dom_time {};
+  bench_clock::duration direct_time {};
+  uint64_t num_states {0};
+  uint64_t num_bytes {0};
+  for (uint32_t repetition {0}; repetition < repetitions; ++repetition) {
+    simulator sim(program);
+    while (true) {
+      const processor_state& state {sim.get_state()};
+
+      auto start {bench_clock::now()};
+      const std::string dom {state.to_json().dump(4)};
+      dom_time += bench_clock::now() - start;
+
+      start = bench_clock::now();
+      const std::string& direct {serializer.serialize(state)};
+      direct_time += bench_clock::now() - start;
+
+      if (dom != direct) {
+        std::cerr << "Serializers disagree at state " << num_states << std::endl;
+        return 1;
+      }
+      num_states++;
+      num_bytes += direct.size();
+
+      if (!sim.can_step()) {
+        break;
+      }
+      sim.step();
+    }
+  }
+
+  const auto ns_per_state = [num_states](const bench_clock::duration duration) {
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) / num_states;
+  };
+  std::cout << "states:          " << num_states << '\n'
+            << "bytes:           " << num_bytes << '\n'
+            << "dom ns/state:    " << ns_per_state(dom_time) << '\n'
+            << "direct ns/state: " << ns_per_state(direct_time) << '\n'
+            << "speedup:         " << ns_per_state(dom_time) / ns_per_state(direct_time) << "x" << std::endl;
+  return 0;
+}
@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "binary_trace.h"
+#include "simulator.h"
+#include "trace_writer.h"
+
+using bench_clock = std::chrono::steady_clock;
+
+/* Measures the throughput of simulator::step in simulated cycles per host
+ * second, on synthetic straight-line programs of 10^3 to 10^6 instructions.
+ * The programs are generated from a fixed seed, so every run simulates the
+ * same cycles:
+ *
+ *   chain        every instruction depends on the previous one
+ *   independent  no instruction depends on another one
+ *   mulu         mostly multiplications between random registers
+ *   divzero      random instructions with nonzero divisions, and a division
+ *                by zero three quarters into the program
+ *
+ * Every program is simulated without a trace, with the binary trace and with
+ * the JSON trace, both written to a stream discarding the bytes. The best of
+ * the repetitions is reported.
+ */
+
+// output stream buffer which drops everything written to it
+class null_buffer : public std::streambuf {
+protected:
+  int overflow(const int c) override { return c; }
+  std::streamsize xsputn(const char*, const std::streamsize n) override { return n; }
+};
+
+enum class trace_mode {
+  off,
+  binary,
+  json,
+};
+
+static instruction_t make_instruction(const opcode op, const uint32_t dest, const uint32_t op_a, const uint32_t op_b,
+  const operand_t imm = 0) {
+  return instruction_t {op, dest, op_a, op_b, imm};
+}
+
+// x1 to x31 start at nonzero values, so that the divisions of the mixes only fault where intended
+static void seed_registers(decoded_program_t& program) {
+  for (uint32_t reg {1}; reg < logical_register_file_size; ++reg) {
+    program.push_back(make_instruction(opcode::addi, reg, 0, 0, reg * 7 + 1));
+  }
+}
+
+static decoded_program_t generate_program(const std::string& mix, const uint32_t size) {
+  std::mt19937_64 rng {size};
+  const auto random_register = [&rng] { return static_cast<uint32_t>(1 + rng() % 30); };
+  decoded_program_t program;
+  program.reserve(size);
+  seed_registers(program);
+
+  while (program.size() < size) {
+    const uint32_t i {static_cast<uint32_t>(program.size())};
+    if (mix == "chain") {
+      const opcode ops[] {opcode::add, opcode::sub, opcode::mulu};
+      program.push_back(make_instruction(ops[i % 3], 1, 1, 2));
+    } else if (mix == "independent") {
+      // x0 and x31 are only written by the seed, so every operand is ready at rename
+      program.push_back(make_instruction(opcode::add, 1 + i % 30, 0, 31));
+    } else if (mix == "mulu") {
+      const opcode op {rng() % 5 == 0 ? opcode::add : opcode::mulu};
+      program.push_back(make_instruction(op, random_register(), random_register(), random_register()));
+    } else {
+      // divisions by x31, except for the one by x0, which stays 0, three quarters into the program
+      const opcode ops[] {opcode::add, opcode::addi, opcode::sub, opcode::mulu, opcode::divu, opcode::remu};
+      const opcode op {ops[rng() % 6]};
+      if (i == size / 4 * 3) {
+        program.push_back(make_instruction(opcode::divu, random_register(), random_register(), 0));
+      } else if (op == opcode::divu || op == opcode::remu) {
+        program.push_back(make_instruction(op, random_register(), random_register(), 31));
+      } else {
+        program.push_back(make_instruction(op, random_register(), random_register(), random_register(), rng()));
+      }
+    }
+  }
+  return program;
+}
+
+// simulates the program to completion, returning the number of cycles and the host time
+static std::pair<uint64_t, double> run(const decoded_program_t& program, const trace_mode mode) {
+  null_buffer buffer;
+  std::ostream null_stream {&buffer};
+  std::unique_ptr<trace_writer> trace;
+  if (mode == trace_mode::binary) {
+    trace = std::make_unique<binary_trace_writer>(null_stream);
+  } else if (mode == trace_mode::json) {
+    trace = std::make_unique<json_trace_writer>(null_stream);
+  }
+
+  const auto start {bench_clock::now()};
+  simulator sim(program);
+  if (trace) {
+    trace->write(sim.get_state());
+  }
+  while (sim.can_step()) {
+    sim.step();
+    if (trace) {
+      trace->write(sim.get_state());
+    }
+  }
+  if (trace) {
+    trace->close();
+  }
+  return {sim.get_cycle(), std::chrono::duration<double>(bench_clock::now() - start).count()};
+}
+
+int main(int argc, char *argv[]) {
+  uint32_t max_size {1000000};
+  uint32_t max_traced_size {100000};
+  uint32_t repetitions {3};
+  for (int i {1}; i < argc; ++i) {
+    if (i + 1 < argc && std::strcmp(argv[i], "--max-size") == 0) {
+      max_size = std::stoul(argv[++i]);
+    } else if (i + 1 < argc && std::strcmp(argv[i], "--max-traced-size") == 0) {
+      max_traced_size = std::stoul(argv[++i]);
+    } else if (i + 1 < argc && std::strcmp(argv[i], "--repetitions") == 0) {
+      repetitions = std::max(1ul, std::stoul(argv[++i]));
+    } else {
+      std::cerr << "Usage: " << argv[0] << " [--max-size <instructions>] [--max-traced-size <instructions>]"
+                << " [--repetitions <n>]" << std::endl;
+      return 1;
+    }
+  }
+
+  std::cout << "simulated Mcycles per host second, best of " << repetitions << " (traces larger than "
+            << max_traced_size << " instructions are skipped)\n";
+  std::cout << std::left << std::setw(14) << "mix" << std::right << std::setw(10) << "size" << std::setw(10)
+            << "cycles" << std::setw(12) << "untraced" << std::setw(12) << "binary" << std::setw(12) << "json" << '\n';
+  std::cout << std::fixed << std::setprecision(3);
+  for (const std::string mix : {"chain", "independent", "mulu", "divzero"}) {
+    for (uint32_t size {1000}; size <= max_size; size *= 10) {
+      const decoded_program_t program {generate_program(mix, size)};
+      std::cout << std::left << std::setw(14) << mix << std::right << std::setw(10) << size;
+      for (const trace_mode mode : {trace_mode::off, trace_mode::binary, trace_mode::json}) {
+        if (mode != trace_mode::off && size > max_traced_size) {
+          std::cout << std::setw(12) << "-";
+          continue;
+        }
+        uint64_t cycles {0};
+        double best_seconds {0};
+        for (uint32_t repetition {0}; repetition < repetitions; ++repetition) {
+          const auto [run_cycles, seconds] {run(program, mode)};
+          cycles = run_cycles;
+          best_seconds = repetition == 0 ? seconds : std::min(best_seconds, seconds);
+        }
+        if (mode == trace_mode::off) {
+          std::cout << std::setw(10) << cycles;
+        }
+        std::cout << std::setw(12) << static_cast<double>(cycles) / best_seconds / 1e6;
+      }
+      std::cout << std::endl;
+    }
+  }
+  return 0;
+}
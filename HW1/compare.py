@@ -17,6 +17,7 @@ args = parser.parse_args()
 INPUT = json.load(args.input)
 REFERENCE = json.load(args.reference)
 
+# A multithreaded INPUT holds the shared fields, and the others in "Threads": [{"ActiveList": [], "DecodedPCs": int, ...}]
 # INPUT is [{"ActiveList": [], "BusyBitTable": [bool], "DecodedPCs": int, "Exception": bool, "ExceptionPC": int, "FreeList": [int], "IntegerQueue": [{}], "PC": int, "PhysicalRegisterFile": [int], "RegisterMapTable": [int], }]
 # ActiveList: [{"Done": bool, "Exception": bool, "LogicalDestination": int, "OldDestination": int, "PC": int}]
 # IntegerQueue: set' [{"DestRegister": int, "OpAIsReady": bool, "OpARegTag": int, "OpAValue": int, "OpBIsReady": bool, "OpBRegTag": int, "OpBValue": int, "OpCode": str, "PC": int}]
@@ -122,9 +123,9 @@ def compareIntegerQueue(i: list[dict], r: list[dict]) -> bool:
             print(f"[{RED}Error{RESET}][IntegerQueue] All integer queue entry should have property 'PC'. ")
             return False
         
-    # Now, sort the list by the PC.
-    i.sort(key=lambda x: x["PC"])
-    r.sort(key=lambda x: x["PC"])
+    # Now, sort the list by the PC, and the threads sharing the queue by the destination register.
+    i.sort(key=lambda x: (x["PC"], x.get("DestRegister", 0)))
+    r.sort(key=lambda x: (x["PC"], x["DestRegister"]))
 
     # First, compare the element count
     if len(i) != len(r):
@@ -194,20 +195,26 @@ def compareActiveList(i: list[dict], r:list[dict]) -> bool:
     return True
 
 
-def compareCycleData(i: dict, r: dict) -> bool:
-    types = {
-        "ActiveList": list, 
-        "BusyBitTable": list, 
-        "DecodedPCs": list, 
-        "Exception": bool, 
-        "ExceptionPC": int, 
-        "FreeList": list,
-        "IntegerQueue": list,
-        "PC": int,
-        "PhysicalRegisterFile": list,
-        "RegisterMapTable": list
-    }
+# the fields of every hardware thread, which a multithreaded output holds in its "Threads" list
+THREAD_TYPES = {
+    "ActiveList": list,
+    "DecodedPCs": list,
+    "Exception": bool,
+    "ExceptionPC": int,
+    "PC": int,
+    "RegisterMapTable": list
+}
+
+# the fields the threads share
+SHARED_TYPES = {
+    "BusyBitTable": list,
+    "FreeList": list,
+    "IntegerQueue": list,
+    "PhysicalRegisterFile": list
+}
+
 
+def checkTypes(i: dict, r: dict, types: dict) -> bool:
     # First, make sure the reference has the correct entry and type.
     for n, t in types.items():
         if not n in r:
@@ -220,10 +227,11 @@ def compareCycleData(i: dict, r: dict) -> bool:
             print("Please check if the reference file is correct.")
             exit(2)
 
-    types.pop("ExceptionPC")
-
     # Second, check user's input to make sure they have the correct type.
     for n, t in types.items():
+        if n == "ExceptionPC":
+            continue
+
         if not n in i:
             print(f"[{RED}Error{RESET}][CycleData] Missing property in the cycle data in the input: {n}")
             return False
@@ -231,25 +239,20 @@ def compareCycleData(i: dict, r: dict) -> bool:
         if type(i[n]) != t:
             print(f"[{RED}Error{RESET}][CycleData] Wrong type of the property in the cycle data in the input: {n}. The expected type is {t}")
             return False
-        
-    # Now, it is time to check each entry.
+
+    return True
+
+
+def compareThreadData(i: dict, r: dict) -> bool:
     if compareActiveList(i["ActiveList"], r["ActiveList"]) == False:
         print(f"[{RED}Error{RESET}][CycleData] Active list mismatched!")
         return False
     
-    for directed_check in ["BusyBitTable", "DecodedPCs", "Exception", "PC", "PhysicalRegisterFile", "RegisterMapTable"]:
+    for directed_check in ["DecodedPCs", "Exception", "PC", "RegisterMapTable"]:
         if i[directed_check] != r[directed_check]:
             print(f"[{RED}Error{RESET}][CycleData] Property '{directed_check}' mismatched.")
             return False
     
-    if set(i["FreeList"]) != set(r["FreeList"]):
-        print(f"[{RED}Error{RESET}][CycleData] Free list mismatched!")
-        return False
-    
-    if compareIntegerQueue(i["IntegerQueue"], r["IntegerQueue"]) == False:
-        print(f"[{RED}Error{RESET}][CycleData] Integer queue mismatched!")
-        return False
-    
     if r["Exception"] == True:
         # compare ExceptionPC
         if not "ExceptionPC" in i:
@@ -266,6 +269,44 @@ def compareCycleData(i: dict, r: dict) -> bool:
 
     return True
 
+
+def compareCycleData(i: dict, r: dict) -> bool:
+    multithreaded = "Threads" in r
+    types = dict(SHARED_TYPES, Threads=list) if multithreaded else dict(SHARED_TYPES, **THREAD_TYPES)
+    if checkTypes(i, r, types) == False:
+        return False
+
+    # Now, it is time to check each entry.
+    for directed_check in ["BusyBitTable", "PhysicalRegisterFile"]:
+        if i[directed_check] != r[directed_check]:
+            print(f"[{RED}Error{RESET}][CycleData] Property '{directed_check}' mismatched.")
+            return False
+    
+    if set(i["FreeList"]) != set(r["FreeList"]):
+        print(f"[{RED}Error{RESET}][CycleData] Free list mismatched!")
+        return False
+    
+    if compareIntegerQueue(i["IntegerQueue"], r["IntegerQueue"]) == False:
+        print(f"[{RED}Error{RESET}][CycleData] Integer queue mismatched!")
+        return False
+
+    if not multithreaded:
+        return compareThreadData(i, r)
+
+    if len(i["Threads"]) != len(r["Threads"]):
+        print(f"[{RED}Error{RESET}][CycleData] Thread count mismatched!")
+        return False
+
+    for idx in range(len(r["Threads"])):
+        if type(i["Threads"][idx]) != dict or checkTypes(i["Threads"][idx], r["Threads"][idx], THREAD_TYPES) == False:
+            return False
+
+        if compareThreadData(i["Threads"][idx], r["Threads"][idx]) == False:
+            print(f"[{RED}Error{RESET}][CycleData] Thread {idx} mismatched!")
+            return False
+
+    return True
+
 # Now it is the final comparison
 if len(INPUT) != len(REFERENCE):
     print(f"[{RED}Error{RESET}][CycleData] Cycle count mismatched!")
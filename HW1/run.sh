@@ -1,3 +1,4 @@
 #!/bin/bash
 
-build/simulate $1 $2
\ No newline at end of file
+# the options after the input and output files, if any, configure the machine
+build/simulate "${@:3}" $1 $2
\ No newline at end of file
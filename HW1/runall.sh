@@ -4,5 +4,6 @@
 
 for tnum in ./given_tests/*
 do
-    ./run.sh ${tnum}/input.json ${tnum}/user_output.json
+    # a test may run on another machine, described by the options in its options.txt
+    ./run.sh ${tnum}/input.json ${tnum}/user_output.json $(cat ${tnum}/options.txt 2>/dev/null)
 done
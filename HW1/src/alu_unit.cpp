@@ -1,6 +1,15 @@
 #include "alu_unit.h"
 
-#include <iostream>
+#include <algorithm>
+#include "logger.h"
+
+alu_unit::alu_unit(const uint32_t alu_id, const machine_config& config)
+  : m_alu_id(alu_id) {
+  for (size_t op {0}; op < num_opcodes; ++op) {
+    m_latencies[op] = latency(config, static_cast<opcode>(op));
+    m_initiation_intervals[op] = initiation_interval(config, static_cast<opcode>(op));
+  }
+}
 
 void alu_unit::step(processor_state &state) {
   // check if we are in exception mode
@@ -9,22 +18,79 @@ void alu_unit::step(processor_state &state) {
     return;
   }
 
-  // check if we have backpressure
+  // check if we have backpressure, which stalls the whole pipeline
   if (!state.alu_results.at(m_alu_id).empty()) {
     return;
   }
 
-  // check if there are instructions to execute
-  if (state.alu_queues.at(m_alu_id).empty()) {
+  auto& pipeline = state.alu_pipelines.at(m_alu_id);
+  auto& queue = state.alu_queues.at(m_alu_id);
+  uint32_t& issue_delay = state.alu_issue_delays.at(m_alu_id);
+  if (issue_delay > 0) {
+    issue_delay--;
+  }
+
+  // start the queued instruction once the interval of the previous one elapsed, if it completes after the others
+  if (!queue.empty() && issue_delay == 0) {
+    const alu_queue_entry_t& queue_entry = queue.front();
+    const uint32_t latency {m_latencies[static_cast<size_t>(queue_entry.op)]};
+    if (pipeline.empty() || latency > pipeline.back().cycles_left) {
+      LOG_DEBUG("alu " << m_alu_id << " executing " << queue_entry.pc << '\n');
+      RECORD_PIPELINE_EVENT(m_recorder, on_execute(queue_entry.pc, queue_entry.dest_register));
+      pipeline.push_back({execute(queue_entry), latency});
+      if (is_branch(queue_entry.op)) {
+        resolve_branch(state, queue_entry);
+      }
+      issue_delay = m_initiation_intervals[static_cast<size_t>(queue_entry.op)];
+      queue.pop_front();
+    }
+  }
+
+  // check if there are instructions executing
+  if (pipeline.empty()) {
     return;
   }
+  state.counters.alu_busy_cycles[m_alu_id]++;
 
-  std::cout << "alu " << m_alu_id << " executing " << state.alu_queues.at(m_alu_id).front().pc << '\n';
+  // the countdowns are distinct, so at most the oldest instruction completes in this cycle
+  for (auto& stage : pipeline) {
+    stage.cycles_left--;
+  }
+  if (pipeline.front().cycles_left == 0) {
+    state.alu_results.at(m_alu_id).push_back(pipeline.front().result);
+    pipeline.pop_front();
+  }
+}
 
-  // get the instruction
-  auto queue_entry = state.alu_queues.at(m_alu_id).front();
-  state.alu_queues.at(m_alu_id).pop();
+uint64_t alu_unit::cycles_until_next_event(const processor_state& state) const {
+  const auto& pipeline = state.alu_pipelines.at(m_alu_id);
+  const auto& queue = state.alu_queues.at(m_alu_id);
+  uint64_t cycles {pipeline.empty() ? 0 : pipeline.front().cycles_left};
+  if (!queue.empty()) {
+    // the queued instruction starts once the interval elapsed and its result would complete after the others
+    const uint32_t latency {m_latencies[static_cast<size_t>(queue.front().op)]};
+    uint64_t start {std::max<uint64_t>(state.alu_issue_delays.at(m_alu_id), 1)};
+    if (!pipeline.empty() && pipeline.back().cycles_left >= latency) {
+      start = std::max<uint64_t>(start, pipeline.back().cycles_left - latency + 2);
+    }
+    cycles = cycles == 0 ? start : std::min(cycles, start);
+  }
+  return cycles;
+}
+
+void alu_unit::skip_cycles(processor_state& state, const uint64_t cycles) const {
+  auto& pipeline = state.alu_pipelines.at(m_alu_id);
+  uint32_t& issue_delay = state.alu_issue_delays.at(m_alu_id);
+  issue_delay -= static_cast<uint32_t>(std::min<uint64_t>(issue_delay, cycles));
+  for (auto& stage : pipeline) {
+    stage.cycles_left -= static_cast<uint32_t>(cycles);
+  }
+  if (!pipeline.empty()) {
+    state.counters.alu_busy_cycles[m_alu_id] += cycles;
+  }
+}
 
+alu_result_t alu_unit::execute(const alu_queue_entry_t& queue_entry) {
   // compute the result
   alu_result_t result {};
   result.dest_register = queue_entry.dest_register;
@@ -58,18 +124,47 @@ void alu_unit::step(processor_state &state) {
       }
       result.result = queue_entry.op_a_value % queue_entry.op_b_value;
       break;
+    case opcode::beq:
+    case opcode::bne:
+    case opcode::bltu:
+    case opcode::bgeu:
+      // the compared register is renamed to a copy of its value
+      result.result = queue_entry.op_a_value;
+      break;
     default:
-      std::cerr << "Unknown opcode: " << static_cast<uint32_t>(queue_entry.op) << '\n';
+      LOG_ERROR("Unknown opcode: " << static_cast<uint32_t>(queue_entry.op) << '\n');
       break;
   }
+  return result;
+}
 
-  // push the result to the result queue
-  state.alu_results.at(m_alu_id).push(result);
+void alu_unit::resolve_branch(processor_state& state, const alu_queue_entry_t& queue_entry) {
+  const operand_t a {queue_entry.op_a_value};
+  const operand_t b {queue_entry.op_b_value};
+  for (auto& branch : state.thread(state.register_threads[queue_entry.dest_register]).branches) {
+    if (branch.is_renamed && branch.dest_register == queue_entry.dest_register) {
+      switch (queue_entry.op) {
+        case opcode::beq:
+          branch.taken = a == b;
+          break;
+        case opcode::bne:
+          branch.taken = a != b;
+          break;
+        case opcode::bltu:
+          branch.taken = a < b;
+          break;
+        default:
+          branch.taken = a >= b;
+          break;
+      }
+      return;
+    }
+  }
 }
 
 void alu_unit::clear(processor_state& state) {
-  // clear the result queue
-  while (!state.alu_results.at(m_alu_id).empty()) {
-    state.alu_results.at(m_alu_id).pop();
-  }
-}
\ No newline at end of file
+  // clear the result queue and the instructions in execution
+  state.alu_results.at(m_alu_id).clear();
+  state.alu_pipelines.at(m_alu_id).clear();
+  state.alu_issue_delays.at(m_alu_id) = 0;
+}
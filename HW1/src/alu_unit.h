@@ -3,15 +3,36 @@
 
 
 
+#include <array>
+#include "machine_config.h"
+#include "pipeline_recorder.h"
 #include "processor_state.h"
 
+/* An ALU executes the instruction in its queue for the latency of its opcode,
+ * and can start the next one after the initiation interval of the opcode, so
+ * that a multiplier with an interval of 1 is pipelined and a divider with an
+ * interval equal to its latency is iterative. Results complete in the order
+ * the instructions started, one per cycle, so an instruction only starts if
+ * it completes after those ahead of it.
+ */
 class alu_unit {
 public:
-  explicit alu_unit(const uint32_t alu_id)
-    : m_alu_id(alu_id) {}
+  alu_unit(uint32_t alu_id, const machine_config& config);
   void step(processor_state& state);
+  // number of cycles until the ALU starts or completes an instruction, or 0 if it holds none
+  uint64_t cycles_until_next_event(const processor_state& state) const;
+  // advances the ALU through idle cycles, in which it neither starts nor completes an instruction
+  void skip_cycles(processor_state& state, uint64_t cycles) const;
+  void set_recorder(pipeline_recorder* recorder) { m_recorder = recorder; }
 private:
+  static constexpr size_t num_opcodes {static_cast<size_t>(opcode::bgeu) + 1};
   uint32_t m_alu_id;
+  std::array<uint32_t, num_opcodes> m_latencies {};
+  std::array<uint32_t, num_opcodes> m_initiation_intervals {};
+  pipeline_recorder* m_recorder {nullptr};
+  static alu_result_t execute(const alu_queue_entry_t& entry);
+  // resolves the direction of a branch in the branch queue, which is checked against its prediction at commit
+  static void resolve_branch(processor_state& state, const alu_queue_entry_t& entry);
   void clear(processor_state& state);
 };
 
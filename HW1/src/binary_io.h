@@ -0,0 +1,91 @@
+#ifndef BINARY_IO_H
+#define BINARY_IO_H
+
+
+
+#include <cstdint>
+#include <istream>
+#include <stdexcept>
+#include <string>
+
+// raised when a binary file is truncated or does not follow the expected format
+class format_error : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
+/* Appends little-endian fixed-width integers and LEB128 variable-length
+ * integers to a byte buffer. The buffer is owned by the caller, so it can be
+ * cleared and reused without releasing its capacity.
+ */
+class byte_writer {
+public:
+  explicit byte_writer(std::string& buffer)
+    : m_buffer(buffer) {}
+  void write_u8(const uint8_t value) { m_buffer += static_cast<char>(value); }
+  void write_u64(uint64_t value) {
+    for (uint32_t i {0}; i < 8; ++i) {
+      write_u8(static_cast<uint8_t>(value));
+      value >>= 8;
+    }
+  }
+  void write_varint(uint64_t value) {
+    while (value >= 0x80) {
+      write_u8(static_cast<uint8_t>(value) | 0x80);
+      value >>= 7;
+    }
+    write_u8(static_cast<uint8_t>(value));
+  }
+  void write_bytes(const char* data, const size_t size) { m_buffer.append(data, size); }
+private:
+  std::string& m_buffer;
+};
+
+// reads back the integers written by byte_writer from a byte range
+class byte_reader {
+public:
+  byte_reader(const char* begin, const char* end)
+    : m_cur(begin), m_end(end) {}
+  explicit byte_reader(const std::string& buffer)
+    : byte_reader(buffer.data(), buffer.data() + buffer.size()) {}
+  bool at_end() const { return m_cur == m_end; }
+  uint8_t read_u8() {
+    if (m_cur == m_end) {
+      throw format_error("unexpected end of data");
+    }
+    return static_cast<uint8_t>(*m_cur++);
+  }
+  uint64_t read_u64() {
+    uint64_t value {0};
+    for (uint32_t i {0}; i < 8; ++i) {
+      value |= static_cast<uint64_t>(read_u8()) << (8 * i);
+    }
+    return value;
+  }
+  uint64_t read_varint() {
+    uint64_t value {0};
+    for (uint32_t shift {0}; shift < 64; shift += 7) {
+      const uint8_t byte {read_u8()};
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        return value;
+      }
+    }
+    throw format_error("variable-length integer is too long");
+  }
+private:
+  const char* m_cur;
+  const char* m_end;
+};
+
+// reads exactly size bytes from a stream into the buffer
+inline void read_exactly(std::istream& is, std::string& buffer, const size_t size) {
+  buffer.resize(size);
+  if (!is.read(buffer.data(), static_cast<std::streamsize>(size))) {
+    throw format_error("unexpected end of file");
+  }
+}
+
+
+
+#endif //BINARY_IO_H
@@ -0,0 +1,445 @@
+#include "binary_trace.h"
+
+#include <stdexcept>
+#include "binary_io.h"
+#include "state_codec.h"
+
+static constexpr char trace_magic[] {"OOOTRACE"};
+static constexpr char index_magic[] {"OOOINDEX"};
+static constexpr uint64_t magic_size {sizeof(trace_magic) - 1};
+static constexpr uint64_t trace_version {1};
+
+// upper bound on the number of elements of a field, to reject corrupted traces early
+static constexpr uint64_t max_field_size {1 << 16};
+
+enum record_kind : uint8_t {
+  keyframe_record,
+  delta_record,
+};
+
+// bits of the mask of fields present in a record
+enum trace_field : uint32_t {
+  pc_field = 1 << 0,
+  physical_register_file_field = 1 << 1,
+  decoded_pcs_field = 1 << 2,
+  exception_pc_field = 1 << 3,
+  exception_field = 1 << 4,
+  register_map_table_field = 1 << 5,
+  free_list_field = 1 << 6,
+  busy_bit_table_field = 1 << 7,
+  active_list_field = 1 << 8,
+  integer_queue_field = 1 << 9,
+  all_fields = (1 << 10) - 1,
+};
+
+void trace_snapshot::capture(const processor_state& state) {
+  pc = state.pc;
+  physical_register_file.assign(state.physical_register_file.begin(), state.physical_register_file.end());
+  decoded_pcs.clear();
+  for (auto& entry : state.decoded_pcs) {
+    decoded_pcs.push_back(entry.first);
+  }
+  exception_pc = state.exception_pc;
+  exception = state.exception;
+  register_map_table.assign(state.register_map_table.begin(), state.register_map_table.end());
+  free_list.assign(state.free_list.begin(), state.free_list.end());
+  busy_bit_table.assign(state.busy_bit_table.begin(), state.busy_bit_table.end());
+  active_list.assign(state.active_list.begin(), state.active_list.end());
+  integer_queue.clear();
+  for (auto& entry : state.integer_queue.in_age_order()) {
+    integer_queue.push_back(entry);
+  }
+}
+
+void trace_snapshot::restore(processor_state& state) const {
+  state.pc = pc;
+  state.physical_register_file.assign(physical_register_file.begin(), physical_register_file.end());
+  state.decoded_pcs.clear();
+  for (const pc_t decoded_pc : decoded_pcs) {
+    // the decoded instruction is not part of the visible state
+    state.decoded_pcs.push_back({decoded_pc, instruction_t {}});
+  }
+  state.exception_pc = exception_pc;
+  state.exception = exception;
+  state.register_map_table.assign(register_map_table.begin(), register_map_table.end());
+  state.free_list.assign(free_list.begin(), free_list.end());
+  state.busy_bit_table.assign(busy_bit_table.begin(), busy_bit_table.end());
+  state.active_list.assign(active_list.begin(), active_list.end());
+  state.integer_queue.clear();
+  for (auto& entry : integer_queue) {
+    state.integer_queue.push_back(entry);
+  }
+}
+
+static bool same_element(const uint64_t a, const uint64_t b) {
+  return a == b;
+}
+
+static bool same_element(const active_list_entry_t& a, const active_list_entry_t& b) {
+  return a.done == b.done
+    && a.exception == b.exception
+    && a.logical_destination == b.logical_destination
+    && a.old_destination == b.old_destination
+    && a.pc == b.pc;
+}
+
+static bool same_element(const integer_queue_entry_t& a, const integer_queue_entry_t& b) {
+  return a.dest_register == b.dest_register
+    && a.op_a_is_ready == b.op_a_is_ready
+    && a.op_a_reg_tag == b.op_a_reg_tag
+    && a.op_a_value == b.op_a_value
+    && a.op_b_is_ready == b.op_b_is_ready
+    && a.op_b_reg_tag == b.op_b_reg_tag
+    && a.op_b_value == b.op_b_value
+    && a.op == b.op
+    && a.pc == b.pc;
+}
+
+template <typename element_t>
+static bool same_elements(const std::vector<element_t>& a, const std::vector<element_t>& b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i {0}; i < a.size(); ++i) {
+    if (!same_element(a[i], b[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// fields are written in full in keyframes: the number of elements followed by every element
+template <typename element_t>
+static void write_full(byte_writer& writer, const std::vector<element_t>& elements) {
+  writer.write_varint(elements.size());
+  for (size_t i {0}; i < elements.size(); ++i) {
+    write_element(writer, elements[i]);
+  }
+}
+
+template <typename element_t>
+static void read_full(byte_reader& reader, std::vector<element_t>& elements) {
+  const uint64_t size {reader.read_varint()};
+  if (size > max_field_size) {
+    throw format_error("field has too many elements");
+  }
+  elements.resize(size);
+  for (size_t i {0}; i < size; ++i) {
+    element_t element {};
+    read_element(reader, element);
+    elements[i] = element;
+  }
+}
+
+// fixed-size tables are written as the number of changed entries followed by their indices and values
+template <typename value_t>
+static void write_table_delta(byte_writer& writer, const std::vector<value_t>& previous, const std::vector<value_t>& current) {
+  uint64_t num_changed {0};
+  for (size_t i {0}; i < current.size(); ++i) {
+    num_changed += previous[i] != current[i];
+  }
+  writer.write_varint(num_changed);
+  for (size_t i {0}; i < current.size(); ++i) {
+    if (previous[i] != current[i]) {
+      writer.write_varint(i);
+      writer.write_varint(current[i]);
+    }
+  }
+}
+
+template <typename value_t>
+static void read_table_delta(byte_reader& reader, std::vector<value_t>& table) {
+  const uint64_t num_changed {reader.read_varint()};
+  for (uint64_t i {0}; i < num_changed; ++i) {
+    const uint64_t index {reader.read_varint()};
+    if (index >= table.size()) {
+      throw format_error("table index out of range");
+    }
+    table[index] = static_cast<value_t>(reader.read_varint());
+  }
+}
+
+/* Lists mostly behave as FIFOs, so they are written as the number of entries
+ * dropped from the front of the previous list, the number of entries kept
+ * after those, and the entries appended after the kept ones.
+ */
+template <typename element_t>
+static void write_list_delta(byte_writer& writer, const std::vector<element_t>& previous, const std::vector<element_t>& current) {
+  size_t best_drop {previous.size()};
+  size_t best_keep {0};
+  for (size_t drop {0}; drop < previous.size() && previous.size() - drop > best_keep; ++drop) {
+    size_t keep {0};
+    while (drop + keep < previous.size() && keep < current.size() && same_element(previous[drop + keep], current[keep])) {
+      keep++;
+    }
+    if (keep > best_keep) {
+      best_drop = drop;
+      best_keep = keep;
+    }
+  }
+
+  writer.write_varint(best_drop);
+  writer.write_varint(best_keep);
+  writer.write_varint(current.size() - best_keep);
+  for (size_t i {best_keep}; i < current.size(); ++i) {
+    write_element(writer, current[i]);
+  }
+}
+
+template <typename element_t>
+static void read_list_delta(byte_reader& reader, std::vector<element_t>& elements) {
+  const uint64_t drop {reader.read_varint()};
+  const uint64_t keep {reader.read_varint()};
+  const uint64_t num_appended {reader.read_varint()};
+  if (drop + keep > elements.size() || keep + num_appended > max_field_size) {
+    throw format_error("list delta out of range");
+  }
+  elements.erase(elements.begin(), elements.begin() + static_cast<std::ptrdiff_t>(drop));
+  elements.resize(keep);
+  for (uint64_t i {0}; i < num_appended; ++i) {
+    element_t element {};
+    read_element(reader, element);
+    elements.push_back(element);
+  }
+}
+
+binary_trace_writer::binary_trace_writer(std::ostream& os, const uint32_t keyframe_interval)
+  : m_os(os), m_keyframe_interval(keyframe_interval == 0 ? 1 : keyframe_interval) {
+  m_record.clear();
+  byte_writer header(m_record);
+  header.write_bytes(trace_magic, magic_size);
+  header.write_u64(trace_version);
+  header.write_u64(m_keyframe_interval);
+  write_raw(m_record);
+}
+
+void binary_trace_writer::write(const processor_state& state) {
+  m_current.capture(state);
+  const bool keyframe {m_num_states % m_keyframe_interval == 0};
+
+  // find the fields which changed since the previous state
+  uint32_t fields {all_fields};
+  if (!keyframe) {
+    fields = 0;
+    fields |= m_previous.pc != m_current.pc ? pc_field : 0u;
+    fields |= m_previous.physical_register_file != m_current.physical_register_file ? physical_register_file_field : 0u;
+    fields |= m_previous.decoded_pcs != m_current.decoded_pcs ? decoded_pcs_field : 0u;
+    fields |= m_previous.exception_pc != m_current.exception_pc ? exception_pc_field : 0u;
+    fields |= m_previous.exception != m_current.exception ? exception_field : 0u;
+    fields |= m_previous.register_map_table != m_current.register_map_table ? register_map_table_field : 0u;
+    fields |= m_previous.free_list != m_current.free_list ? free_list_field : 0u;
+    fields |= m_previous.busy_bit_table != m_current.busy_bit_table ? busy_bit_table_field : 0u;
+    fields |= !same_elements(m_previous.active_list, m_current.active_list) ? active_list_field : 0u;
+    fields |= !same_elements(m_previous.integer_queue, m_current.integer_queue) ? integer_queue_field : 0u;
+  }
+
+  // encode the payload of the record
+  m_payload.clear();
+  byte_writer payload(m_payload);
+  payload.write_u8(keyframe ? keyframe_record : delta_record);
+  payload.write_varint(fields);
+  if (fields & pc_field) {
+    payload.write_varint(m_current.pc);
+  }
+  if (fields & physical_register_file_field) {
+    keyframe ? write_full(payload, m_current.physical_register_file)
+             : write_table_delta(payload, m_previous.physical_register_file, m_current.physical_register_file);
+  }
+  if (fields & decoded_pcs_field) {
+    keyframe ? write_full(payload, m_current.decoded_pcs)
+             : write_list_delta(payload, m_previous.decoded_pcs, m_current.decoded_pcs);
+  }
+  if (fields & exception_pc_field) {
+    payload.write_varint(m_current.exception_pc);
+  }
+  if (fields & exception_field) {
+    payload.write_varint(m_current.exception);
+  }
+  if (fields & register_map_table_field) {
+    keyframe ? write_full(payload, m_current.register_map_table)
+             : write_table_delta(payload, m_previous.register_map_table, m_current.register_map_table);
+  }
+  if (fields & free_list_field) {
+    keyframe ? write_full(payload, m_current.free_list)
+             : write_list_delta(payload, m_previous.free_list, m_current.free_list);
+  }
+  if (fields & busy_bit_table_field) {
+    keyframe ? write_full(payload, m_current.busy_bit_table)
+             : write_table_delta(payload, m_previous.busy_bit_table, m_current.busy_bit_table);
+  }
+  if (fields & active_list_field) {
+    keyframe ? write_full(payload, m_current.active_list)
+             : write_list_delta(payload, m_previous.active_list, m_current.active_list);
+  }
+  if (fields & integer_queue_field) {
+    keyframe ? write_full(payload, m_current.integer_queue)
+             : write_list_delta(payload, m_previous.integer_queue, m_current.integer_queue);
+  }
+
+  // write the record, prefixed by its size
+  if (keyframe) {
+    m_keyframe_offsets.push_back(m_offset);
+  }
+  m_record.clear();
+  byte_writer record(m_record);
+  record.write_varint(m_payload.size());
+  write_raw(m_record);
+  write_raw(m_payload);
+
+  std::swap(m_previous, m_current);
+  m_num_states++;
+}
+
+void binary_trace_writer::close() {
+  if (m_closed) {
+    return;
+  }
+
+  // write the index followed by the trailer pointing to it
+  const uint64_t index_offset {m_offset};
+  m_record.clear();
+  byte_writer index(m_record);
+  index.write_u64(m_num_states);
+  index.write_u64(m_keyframe_offsets.size());
+  for (const uint64_t offset : m_keyframe_offsets) {
+    index.write_u64(offset);
+  }
+  index.write_u64(index_offset);
+  index.write_bytes(index_magic, magic_size);
+  write_raw(m_record);
+  m_os.flush();
+  m_closed = true;
+}
+
+void binary_trace_writer::write_raw(const std::string& bytes) {
+  m_os.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  m_offset += bytes.size();
+}
+
+binary_trace_reader::binary_trace_reader(std::istream& is)
+  : m_is(is) {
+  // read the header
+  read_exactly(m_is, m_record, magic_size + 16);
+  byte_reader header(m_record);
+  if (m_record.compare(0, magic_size, trace_magic) != 0) {
+    throw format_error("not a binary trace");
+  }
+  for (uint64_t i {0}; i < magic_size; ++i) {
+    header.read_u8();
+  }
+  if (header.read_u64() != trace_version) {
+    throw format_error("unsupported trace version");
+  }
+  m_keyframe_interval = static_cast<uint32_t>(header.read_u64());
+  if (m_keyframe_interval == 0) {
+    throw format_error("invalid keyframe interval");
+  }
+
+  // read the trailer, then the index it points to
+  m_is.seekg(-static_cast<std::streamoff>(8 + magic_size), std::ios::end);
+  read_exactly(m_is, m_record, 8 + magic_size);
+  if (m_record.compare(8, magic_size, index_magic) != 0) {
+    throw format_error("missing trace index, the trace may be truncated");
+  }
+  const uint64_t index_offset {byte_reader(m_record).read_u64()};
+  m_is.seekg(static_cast<std::streamoff>(index_offset));
+  read_exactly(m_is, m_record, 16);
+  byte_reader index_header(m_record);
+  m_num_states = index_header.read_u64();
+  const uint64_t num_keyframes {index_header.read_u64()};
+  if (num_keyframes != (m_num_states + m_keyframe_interval - 1) / m_keyframe_interval) {
+    throw format_error("trace index does not match the number of states");
+  }
+  read_exactly(m_is, m_record, 8 * num_keyframes);
+  byte_reader offsets(m_record);
+  for (uint64_t i {0}; i < num_keyframes; ++i) {
+    m_keyframe_offsets.push_back(offsets.read_u64());
+  }
+}
+
+const processor_state& binary_trace_reader::read_state(const uint64_t index) {
+  if (index >= m_num_states) {
+    throw std::out_of_range("state index out of range");
+  }
+
+  // seek to the closest keyframe unless the state can be reached by replaying forward from the current one
+  const uint64_t keyframe {index / m_keyframe_interval};
+  if (!m_positioned || index + 1 < m_next_index || keyframe * m_keyframe_interval >= m_next_index) {
+    m_is.clear();
+    m_is.seekg(static_cast<std::streamoff>(m_keyframe_offsets.at(keyframe)));
+    m_next_index = keyframe * m_keyframe_interval;
+    m_positioned = true;
+  }
+  while (m_next_index <= index) {
+    read_record();
+    m_next_index++;
+  }
+
+  m_snapshot.restore(m_state);
+  return m_state;
+}
+
+void binary_trace_reader::read_record() {
+  // read the size of the payload, then the payload
+  uint64_t size {0};
+  for (uint32_t shift {0};; shift += 7) {
+    const int byte {m_is.get()};
+    if (byte == std::char_traits<char>::eof() || shift >= 64) {
+      throw format_error("malformed record size");
+    }
+    size |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      break;
+    }
+  }
+  read_exactly(m_is, m_record, size);
+
+  byte_reader payload(m_record);
+  const uint8_t kind {payload.read_u8()};
+  const uint64_t fields {payload.read_varint()};
+  const bool keyframe {kind == keyframe_record};
+  if ((keyframe && fields != all_fields) || (!keyframe && kind != delta_record)) {
+    throw format_error("malformed record");
+  }
+
+  if (fields & pc_field) {
+    read_element(payload, m_snapshot.pc);
+  }
+  if (fields & physical_register_file_field) {
+    keyframe ? read_full(payload, m_snapshot.physical_register_file)
+             : read_table_delta(payload, m_snapshot.physical_register_file);
+  }
+  if (fields & decoded_pcs_field) {
+    keyframe ? read_full(payload, m_snapshot.decoded_pcs)
+             : read_list_delta(payload, m_snapshot.decoded_pcs);
+  }
+  if (fields & exception_pc_field) {
+    read_element(payload, m_snapshot.exception_pc);
+  }
+  if (fields & exception_field) {
+    m_snapshot.exception = payload.read_varint() != 0;
+  }
+  if (fields & register_map_table_field) {
+    keyframe ? read_full(payload, m_snapshot.register_map_table)
+             : read_table_delta(payload, m_snapshot.register_map_table);
+  }
+  if (fields & free_list_field) {
+    keyframe ? read_full(payload, m_snapshot.free_list)
+             : read_list_delta(payload, m_snapshot.free_list);
+  }
+  if (fields & busy_bit_table_field) {
+    keyframe ? read_full(payload, m_snapshot.busy_bit_table)
+             : read_table_delta(payload, m_snapshot.busy_bit_table);
+  }
+  if (fields & active_list_field) {
+    keyframe ? read_full(payload, m_snapshot.active_list)
+             : read_list_delta(payload, m_snapshot.active_list);
+  }
+  if (fields & integer_queue_field) {
+    keyframe ? read_full(payload, m_snapshot.integer_queue)
+             : read_list_delta(payload, m_snapshot.integer_queue);
+  }
+  if (!payload.at_end()) {
+    throw format_error("trailing bytes in record");
+  }
+}
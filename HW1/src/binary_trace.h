@@ -0,0 +1,93 @@
+#ifndef BINARY_TRACE_H
+#define BINARY_TRACE_H
+
+
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "common.h"
+#include "processor_state.h"
+#include "trace_writer.h"
+
+/* Compact binary trace of the visible processor states, i.e., the fields of
+ * the JSON output. The file is laid out as follows, with integers in records
+ * encoded as LEB128 variable-length integers and other integers as
+ * little-endian 64-bit values:
+ *
+ *   header   "OOOTRACE", version, keyframe interval
+ *   records  one per state: payload size, kind (keyframe or delta), mask of
+ *            the fields present in the record, encoded fields
+ *   index    number of states, number of keyframes, offset of every keyframe
+ *   trailer  offset of the index, "OOOINDEX"
+ *
+ * Every keyframe_interval-th state is a keyframe holding all fields in full.
+ * The other states are deltas against the previous state which only hold the
+ * fields that changed: the indices and values of the changed entries of the
+ * fixed-size tables, and for the FIFO-like lists, how many entries were
+ * dropped from the front, how many were kept and the entries appended. The
+ * index allows reconstructing any state by replaying at most
+ * keyframe_interval - 1 deltas from the closest keyframe.
+ */
+constexpr uint32_t default_keyframe_interval {1024};
+
+// the visible fields of a processor state, in flat vectors that can be reused between states
+struct trace_snapshot {
+  pc_t pc {};
+  std::vector<uint64_t> physical_register_file;
+  std::vector<pc_t> decoded_pcs;
+  pc_t exception_pc {};
+  bool exception {};
+  std::vector<reg_t> register_map_table;
+  std::vector<reg_t> free_list;
+  std::vector<bool> busy_bit_table;
+  std::vector<active_list_entry_t> active_list;
+  std::vector<integer_queue_entry_t> integer_queue;
+
+  void capture(const processor_state& state);
+  void restore(processor_state& state) const;
+};
+
+class binary_trace_writer : public trace_writer {
+public:
+  explicit binary_trace_writer(std::ostream& os, uint32_t keyframe_interval = default_keyframe_interval);
+  void write(const processor_state& state) override;
+  void close() override;
+private:
+  void write_raw(const std::string& bytes);
+  std::ostream& m_os;
+  uint32_t m_keyframe_interval;
+  uint64_t m_num_states {0};
+  uint64_t m_offset {0};
+  std::vector<uint64_t> m_keyframe_offsets;
+  trace_snapshot m_previous;
+  trace_snapshot m_current;
+  std::string m_payload;
+  std::string m_record;
+  bool m_closed {false};
+};
+
+class binary_trace_reader {
+public:
+  // reads the header and the index, throwing a format_error if the trace is malformed
+  explicit binary_trace_reader(std::istream& is);
+  uint64_t num_states() const { return m_num_states; }
+  // reconstructs the state of the given index, which is cheapest when reading states in order
+  const processor_state& read_state(uint64_t index);
+private:
+  void read_record();
+  std::istream& m_is;
+  uint32_t m_keyframe_interval {};
+  uint64_t m_num_states {};
+  std::vector<uint64_t> m_keyframe_offsets;
+  uint64_t m_next_index {};
+  bool m_positioned {false};
+  trace_snapshot m_snapshot;
+  processor_state m_state;
+  std::string m_record;
+};
+
+
+
+#endif //BINARY_TRACE_H
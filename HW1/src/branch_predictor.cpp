@@ -0,0 +1,145 @@
+#include "branch_predictor.h"
+
+#include <algorithm>
+
+// the lowest bits of a history, xored together in chunks of the given width
+static uint64_t fold(const uint64_t history, const uint32_t length, const uint32_t width) {
+  if (width == 0) {
+    return 0;
+  }
+  uint64_t bits {length < 64 ? history & ((uint64_t {1} << length) - 1) : history};
+  uint64_t folded {0};
+  while (bits != 0) {
+    folded ^= bits & ((uint64_t {1} << width) - 1);
+    bits >>= width;
+  }
+  return folded;
+}
+
+// moves a saturating counter towards the direction of the branch
+static void train(uint8_t& counter, const bool taken, const uint8_t max) {
+  if (taken && counter < max) {
+    counter++;
+  } else if (!taken && counter > 0) {
+    counter--;
+  }
+}
+
+branch_predictor::branch_predictor(const machine_config& config)
+  : m_kind(config.branch_predictor),
+    m_index_bits(config.predictor_index_bits),
+    m_history_length(config.predictor_history_length),
+    m_counters(size_t {1} << config.predictor_index_bits, 1) {
+  // the counters start weakly not taken, and the tagged tables empty with tags which no branch matches
+  if (m_kind == branch_predictor_kind::tage) {
+    m_tagged.assign(num_tagged_tables << (m_index_bits - 3), tage_entry_t {uint16_t {1} << tag_bits, 0, 0});
+  }
+}
+
+bool branch_predictor::predict(const pc_t pc, const uint64_t history) const {
+  if (m_kind == branch_predictor_kind::tage) {
+    const uint32_t provider {find_provider(pc, history, num_tagged_tables)};
+    if (provider != num_tagged_tables) {
+      return m_tagged[tagged_index(provider, pc, history)].counter >= 4;
+    }
+  }
+  return m_counters[base_index(pc, history)] >= 2;
+}
+
+void branch_predictor::update(const pc_t pc, const uint64_t history, const bool taken) {
+  if (m_kind != branch_predictor_kind::tage) {
+    train(m_counters[base_index(pc, history)], taken, 3);
+    return;
+  }
+
+  // the provider and the alternate prediction it would have fallen back to
+  uint8_t& base {m_counters[base_index(pc, history)]};
+  const uint32_t provider {find_provider(pc, history, num_tagged_tables)};
+  bool prediction {base >= 2};
+  if (provider == num_tagged_tables) {
+    train(base, taken, 3);
+  } else {
+    tage_entry_t& entry {m_tagged[tagged_index(provider, pc, history)]};
+    const uint32_t alternate {find_provider(pc, history, provider)};
+    const bool alternate_prediction {alternate == num_tagged_tables ? base >= 2
+      : m_tagged[tagged_index(alternate, pc, history)].counter >= 4};
+    prediction = entry.counter >= 4;
+    if (prediction != alternate_prediction) {
+      train(entry.useful, prediction == taken, 3);
+    }
+    train(entry.counter, taken, 7);
+  }
+  if (prediction == taken) {
+    return;
+  }
+
+  // allocate an entry with a longer history, or make room for the next misprediction
+  const uint32_t first {provider == num_tagged_tables ? 0 : provider + 1};
+  for (uint32_t table {first}; table < num_tagged_tables; ++table) {
+    tage_entry_t& entry {m_tagged[tagged_index(table, pc, history)]};
+    if (entry.useful == 0) {
+      entry = {tag(table, pc, history), static_cast<uint8_t>(taken ? 4 : 3), 0};
+      return;
+    }
+  }
+  for (uint32_t table {first}; table < num_tagged_tables; ++table) {
+    train(m_tagged[tagged_index(table, pc, history)].useful, false, 3);
+  }
+}
+
+uint64_t branch_predictor::next_history(const uint64_t history, const bool taken) const {
+  const uint64_t shifted {history << 1 | static_cast<uint64_t>(taken)};
+  return m_history_length < 64 ? shifted & ((uint64_t {1} << m_history_length) - 1) : shifted;
+}
+
+bool branch_predictor::restore(const std::vector<uint8_t>& counters,
+  const std::vector<tage_entry_t>& tagged_entries) {
+  if (counters.size() != m_counters.size() || tagged_entries.size() != m_tagged.size()) {
+    return false;
+  }
+  for (const uint8_t counter : counters) {
+    if (counter > 3) {
+      return false;
+    }
+  }
+  for (const tage_entry_t& entry : tagged_entries) {
+    if (entry.tag > uint16_t {1} << tag_bits || entry.counter > 7 || entry.useful > 3) {
+      return false;
+    }
+  }
+  m_counters = counters;
+  m_tagged = tagged_entries;
+  return true;
+}
+
+uint32_t branch_predictor::base_index(const pc_t pc, const uint64_t history) const {
+  const uint64_t mask {(uint64_t {1} << m_index_bits) - 1};
+  if (m_kind == branch_predictor_kind::gshare) {
+    return static_cast<uint32_t>((pc ^ fold(history, m_history_length, m_index_bits)) & mask);
+  }
+  return static_cast<uint32_t>(pc & mask);
+}
+
+uint32_t branch_predictor::tagged_index(const uint32_t table, const pc_t pc, const uint64_t history) const {
+  // the tables look at an eighth, a quarter, a half and all of the history
+  const uint32_t bits {m_index_bits - 3};
+  const uint32_t length {std::max(m_history_length >> (num_tagged_tables - 1 - table), 1u)};
+  const uint64_t index {(pc ^ pc >> bits ^ fold(history, length, bits)) & ((uint64_t {1} << bits) - 1)};
+  return static_cast<uint32_t>(table << bits | index);
+}
+
+uint16_t branch_predictor::tag(const uint32_t table, const pc_t pc, const uint64_t history) const {
+  // folded differently from the index, so that the branches sharing an entry rarely share a tag
+  const uint32_t length {std::max(m_history_length >> (num_tagged_tables - 1 - table), 1u)};
+  const uint64_t folded {fold(history, length, tag_bits) ^ fold(history, length, tag_bits - 1) << 1};
+  return static_cast<uint16_t>((pc ^ folded) & ((uint64_t {1} << tag_bits) - 1));
+}
+
+uint32_t branch_predictor::find_provider(const pc_t pc, const uint64_t history, const uint32_t below) const {
+  for (uint32_t table {below}; table > 0; --table) {
+    if (m_tagged[tagged_index(table - 1, pc, history)].tag == tag(table - 1, pc, history)) {
+      return table - 1;
+    }
+  }
+  return num_tagged_tables;
+}
@@ -0,0 +1,59 @@
+#ifndef BRANCH_PREDICTOR_H
+#define BRANCH_PREDICTOR_H
+
+
+
+#include <cstdint>
+#include <vector>
+#include "common.h"
+#include "machine_config.h"
+
+/* Direction predictor of the conditional branches, looked up with the pc of
+ * a branch and the global history of the directions of the branches fetched
+ * before it, the most recent one in bit 0. The bimodal and gshare predictors
+ * are a table of 2-bit saturating counters, indexed by the pc, or by the pc
+ * xor the history folded to the index bits.
+ *
+ * TAGE-lite adds to a bimodal base four tagged tables of an eighth of its
+ * size, indexed and tagged with an eighth, a quarter, a half and all of the
+ * history. The longest table whose tag matches provides the prediction with
+ * a 3-bit counter, and its useful counter tracks whether it predicts better
+ * than the next shorter match. A misprediction allocates an entry in the
+ * first longer table whose useful counter is 0, or ages the useful counters
+ * of the longer tables if none is.
+ *
+ * The predictor is trained as the branches commit, with the history they
+ * were predicted with, so that the wrong path never reaches the tables.
+ */
+class branch_predictor {
+public:
+  branch_predictor() = default;
+  explicit branch_predictor(const machine_config& config);
+  // returns true if the branch at pc is predicted taken after the given history
+  bool predict(pc_t pc, uint64_t history) const;
+  // trains the predictor with the direction of a branch, predicted with the given history
+  void update(pc_t pc, uint64_t history, bool taken);
+  // appends a direction to a history, keeping the configured number of bits
+  uint64_t next_history(uint64_t history, bool taken) const;
+  const std::vector<uint8_t>& counters() const { return m_counters; }
+  const std::vector<tage_entry_t>& tagged_entries() const { return m_tagged; }
+  // restores the tables saved from the accessors above, returning false if they do not fit the predictor
+  bool restore(const std::vector<uint8_t>& counters, const std::vector<tage_entry_t>& tagged_entries);
+private:
+  static constexpr uint32_t num_tagged_tables {4};
+  static constexpr uint32_t tag_bits {8};
+  uint32_t base_index(pc_t pc, uint64_t history) const;
+  uint32_t tagged_index(uint32_t table, pc_t pc, uint64_t history) const;
+  uint16_t tag(uint32_t table, pc_t pc, uint64_t history) const;
+  // longest tagged table below the given one holding the branch, or num_tagged_tables if none does
+  uint32_t find_provider(pc_t pc, uint64_t history, uint32_t below) const;
+  branch_predictor_kind m_kind {branch_predictor_kind::gshare};
+  uint32_t m_index_bits {1};
+  uint32_t m_history_length {1};
+  std::vector<uint8_t> m_counters; // the 2-bit counters of the bimodal table
+  std::vector<tage_entry_t> m_tagged; // the tagged tables of TAGE one after the other, shortest history first
+};
+
+
+
+#endif //BRANCH_PREDICTOR_H
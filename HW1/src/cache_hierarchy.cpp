@@ -0,0 +1,222 @@
+#include "cache_hierarchy.h"
+
+// number of bits of a power of two
+static uint32_t log2_of(const uint32_t power_of_two) {
+  uint32_t bits {0};
+  while ((1u << bits) < power_of_two) {
+    bits++;
+  }
+  return bits;
+}
+
+// 4-bit LRU rank of a way in the replacement word of its set
+static uint64_t rank_of(const uint64_t ranks, const uint32_t way) {
+  return ranks >> (4 * way) & 0xf;
+}
+
+cache_level::cache_level(const uint32_t num_sets, const uint32_t num_ways, const cache_replacement policy)
+  : m_num_ways(num_ways),
+    m_set_bits(log2_of(num_sets)),
+    m_policy(policy),
+    m_tags(static_cast<size_t>(num_sets) * num_ways, 0),
+    m_valid(num_sets, 0),
+    m_replacement(num_sets, 0) {
+  // the ways start ranked by their index, and the pseudo-LRU trees all point to way 0
+  if (m_policy == cache_replacement::lru) {
+    uint64_t ranks {0};
+    for (uint32_t way {0}; way < m_num_ways; ++way) {
+      ranks |= static_cast<uint64_t>(way) << (4 * way);
+    }
+    m_replacement.assign(num_sets, ranks);
+  }
+}
+
+bool cache_level::access(const uint64_t line) {
+  const uint64_t set {line & ((uint64_t {1} << m_set_bits) - 1)};
+  const auto way {find(set, line >> m_set_bits)};
+  if (!way) {
+    return false;
+  }
+  touch(set, *way);
+  return true;
+}
+
+void cache_level::fill(const uint64_t line) {
+  const uint64_t set {line & ((uint64_t {1} << m_set_bits) - 1)};
+  const uint64_t tag {line >> m_set_bits};
+  uint32_t way {0};
+  if (const auto hit {find(set, tag)}) {
+    way = *hit;
+  } else {
+    way = victim(set);
+    m_tags[set * m_num_ways + way] = tag;
+    m_valid[set] |= static_cast<uint16_t>(1u << way);
+  }
+  touch(set, way);
+}
+
+bool cache_level::restore(const std::vector<uint64_t>& tags, const std::vector<uint16_t>& valid,
+  const std::vector<uint64_t>& replacement) {
+  if (tags.size() != m_tags.size() || valid.size() != m_valid.size() || replacement.size() != m_replacement.size()) {
+    return false;
+  }
+  for (const uint16_t mask : valid) {
+    if (m_num_ways < cache_ways_limit && mask >> m_num_ways != 0) {
+      return false;
+    }
+  }
+  m_tags = tags;
+  m_valid = valid;
+  m_replacement = replacement;
+  return true;
+}
+
+std::optional<uint32_t> cache_level::find(const uint64_t set, const uint64_t tag) const {
+  const uint64_t* set_tags {&m_tags[set * m_num_ways]};
+  for (uint32_t way {0}; way < m_num_ways; ++way) {
+    if (set_tags[way] == tag && (m_valid[set] >> way & 1)) {
+      return way;
+    }
+  }
+  return std::nullopt;
+}
+
+void cache_level::touch(const uint64_t set, const uint32_t way) {
+  uint64_t& state {m_replacement[set]};
+  if (m_policy == cache_replacement::lru) {
+    // the ways more recent than this one age by one, and this one becomes the most recent
+    const uint64_t rank {rank_of(state, way)};
+    for (uint32_t other {0}; other < m_num_ways; ++other) {
+      if (rank_of(state, other) < rank) {
+        state += uint64_t {1} << (4 * other);
+      }
+    }
+    state &= ~(uint64_t {0xf} << (4 * way));
+    return;
+  }
+
+  // every node on the path from the root to the way points to the other subtree
+  uint64_t node {1};
+  for (uint32_t level {log2_of(m_num_ways)}; level > 0; --level) {
+    const uint64_t direction {way >> (level - 1) & 1};
+    state = (state & ~(uint64_t {1} << node)) | (direction ^ 1) << node;
+    node = 2 * node + direction;
+  }
+}
+
+uint32_t cache_level::victim(const uint64_t set) const {
+  // fill the invalid ways first
+  const uint32_t invalid {static_cast<uint32_t>(~m_valid[set]) & ((1u << m_num_ways) - 1)};
+  if (invalid != 0) {
+    uint32_t way {0};
+    while (!(invalid >> way & 1)) {
+      way++;
+    }
+    return way;
+  }
+
+  const uint64_t state {m_replacement[set]};
+  uint32_t way {0};
+  if (m_policy == cache_replacement::lru) {
+    for (uint32_t other {1}; other < m_num_ways; ++other) {
+      if (rank_of(state, other) > rank_of(state, way)) {
+        way = other;
+      }
+    }
+    return way;
+  }
+
+  // follow the nodes from the root to the least recently used leaf
+  uint64_t node {1};
+  for (uint32_t level {log2_of(m_num_ways)}; level > 0; --level) {
+    const uint64_t direction {state >> node & 1};
+    way = way << 1 | static_cast<uint32_t>(direction);
+    node = 2 * node + direction;
+  }
+  return way;
+}
+
+cache_hierarchy::cache_hierarchy(const machine_config& config)
+  : l1(config.l1_sets, config.l1_ways, config.cache_replacement_policy),
+    l2(config.l2_sets, config.l2_ways, config.cache_replacement_policy),
+    m_line_bits(log2_of(config.cache_line_words)),
+    m_l1_latency(config.l1_latency),
+    m_l2_latency(config.l2_latency),
+    m_memory_latency(config.memory_latency),
+    m_num_mshrs(config.mshrs) {}
+
+std::optional<uint32_t> cache_hierarchy::load(const uint64_t address, perf_counters_t& counters) {
+  const uint64_t line {address >> m_line_bits};
+  if (l1.access(line)) {
+    counters.l1_hits++;
+    return m_l1_latency;
+  }
+
+  // a line already on its way serves every load missing on it
+  for (const auto& mshr : mshrs) {
+    if (mshr.line == line) {
+      counters.mshr_merges++;
+      return mshr.cycles_left;
+    }
+  }
+  if (mshrs.size() == m_num_mshrs) {
+    return std::nullopt;
+  }
+
+  counters.l1_misses++;
+  uint32_t latency {m_l1_latency + m_l2_latency};
+  if (l2.access(line)) {
+    counters.l2_hits++;
+  } else {
+    counters.l2_misses++;
+    latency += m_memory_latency;
+    l2.fill(line);
+  }
+  mshrs.push_back({line, latency});
+  return latency;
+}
+
+void cache_hierarchy::store(const uint64_t address, perf_counters_t& counters) {
+  const uint64_t line {address >> m_line_bits};
+  if (l1.access(line)) {
+    counters.l1_store_hits++;
+    return;
+  }
+  counters.l1_store_misses++;
+  if (l2.access(line)) {
+    counters.l2_hits++;
+  } else {
+    counters.l2_misses++;
+    l2.fill(line);
+  }
+  l1.fill(line);
+}
+
+void cache_hierarchy::step() {
+  // keep the misses in flight in order, dropping the ones whose line arrived
+  for (size_t i {mshrs.size()}; i > 0; --i) {
+    mshr_t mshr {mshrs.front()};
+    mshrs.pop_front();
+    if (--mshr.cycles_left == 0) {
+      l1.fill(mshr.line);
+    } else {
+      mshrs.push_back(mshr);
+    }
+  }
+}
+
+uint64_t cache_hierarchy::cycles_until_next_event() const {
+  uint64_t next_event {0};
+  for (const auto& mshr : mshrs) {
+    if (next_event == 0 || mshr.cycles_left < next_event) {
+      next_event = mshr.cycles_left;
+    }
+  }
+  return next_event;
+}
+
+void cache_hierarchy::skip_cycles(const uint64_t num_cycles) {
+  for (auto& mshr : mshrs) {
+    mshr.cycles_left -= static_cast<uint32_t>(num_cycles);
+  }
+}
@@ -0,0 +1,84 @@
+#ifndef CACHE_HIERARCHY_H
+#define CACHE_HIERARCHY_H
+
+
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "common.h"
+#include "machine_config.h"
+#include "perf_counters.h"
+#include "ring_buffer.h"
+
+/* One level of a set-associative cache, which only tracks the lines it
+ * holds, as the values stay in the data memory. The tags, i.e., the line
+ * addresses above the set index bits, are packed in one array with the ways
+ * of a set next to each other, and a set keeps a mask of its valid ways. The
+ * replacement state of a set fits in one word: the 4-bit recency rank of
+ * every way for LRU, 0 being the most recently used, or the ways - 1 node
+ * bits of the tree for pseudo-LRU.
+ */
+class cache_level {
+public:
+  cache_level() = default;
+  cache_level(uint32_t num_sets, uint32_t num_ways, cache_replacement policy);
+  // returns true and marks the line as the most recently used if the cache holds it
+  bool access(uint64_t line);
+  // makes the line the most recently used, replacing the victim of its set if the cache does not hold it
+  void fill(uint64_t line);
+  const std::vector<uint64_t>& tags() const { return m_tags; }
+  const std::vector<uint16_t>& valid_ways() const { return m_valid; }
+  const std::vector<uint64_t>& replacement_state() const { return m_replacement; }
+  // restores the state saved from the accessors above, returning false if it does not fit the cache
+  bool restore(const std::vector<uint64_t>& tags, const std::vector<uint16_t>& valid,
+    const std::vector<uint64_t>& replacement);
+private:
+  // way of the set holding the line, if there is one
+  std::optional<uint32_t> find(uint64_t set, uint64_t tag) const;
+  void touch(uint64_t set, uint32_t way);
+  uint32_t victim(uint64_t set) const;
+  uint32_t m_num_ways {1};
+  uint32_t m_set_bits {0};
+  cache_replacement m_policy {cache_replacement::lru};
+  std::vector<uint64_t> m_tags;
+  std::vector<uint16_t> m_valid;
+  std::vector<uint64_t> m_replacement;
+};
+
+/* L1 and L2 data caches in front of a fixed-latency memory. A load hitting
+ * the L1 gets its data after the L1 latency. A miss takes an MSHR until its
+ * line arrives from the L2, or from the memory if the L2 misses too, and the
+ * loads missing on the same line meanwhile wait for the same MSHR. A load
+ * missing while every MSHR is busy has to try again. Stores write the caches
+ * when they commit, through a write buffer which never stalls, allocating
+ * their line in both levels on a miss.
+ */
+class cache_hierarchy {
+public:
+  cache_hierarchy() = default;
+  explicit cache_hierarchy(const machine_config& config);
+  // returns the cycles until the data of the load is ready, or std::nullopt if it misses and every MSHR is busy
+  std::optional<uint32_t> load(uint64_t address, perf_counters_t& counters);
+  void store(uint64_t address, perf_counters_t& counters);
+  // advances the misses in flight, filling the L1 with the lines which arrived
+  void step();
+  // cycles until the next line arrives, or 0 if no miss is in flight
+  uint64_t cycles_until_next_event() const;
+  // advances through cycles in which no line arrives
+  void skip_cycles(uint64_t num_cycles);
+
+  cache_level l1;
+  cache_level l2;
+  ring_buffer<mshr_t, mshrs_limit> mshrs; // the misses in flight, oldest first
+private:
+  uint32_t m_line_bits {0};
+  uint32_t m_l1_latency {1};
+  uint32_t m_l2_latency {1};
+  uint32_t m_memory_latency {1};
+  uint32_t m_num_mshrs {1};
+};
+
+
+
+#endif //CACHE_HIERARCHY_H
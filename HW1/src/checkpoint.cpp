@@ -0,0 +1,454 @@
+#include "checkpoint.h"
+
+#include <iterator>
+#include <string>
+#include <vector>
+#include "binary_io.h"
+#include "state_codec.h"
+
+static constexpr char checkpoint_magic[] {"OOOCHKPT"};
+static constexpr uint64_t magic_size {sizeof(checkpoint_magic) - 1};
+static constexpr uint64_t checkpoint_version {10};
+
+// upper bound on the number of instructions of a program, to reject corrupted checkpoints early
+static constexpr uint64_t max_program_size {1 << 24};
+
+template <typename container_t>
+static void write_list(byte_writer& writer, const container_t& elements) {
+  writer.write_varint(elements.size());
+  for (const auto& element : elements) {
+    write_element(writer, element);
+  }
+}
+
+// reads the size of a list, which must not exceed the capacity of the structure holding it
+static uint64_t read_size(byte_reader& reader, const uint64_t capacity, const char* name) {
+  const uint64_t size {reader.read_varint()};
+  if (size > capacity) {
+    throw format_error(std::string {name} + " has more entries than the machine holds");
+  }
+  return size;
+}
+
+template <typename value_t>
+static std::vector<value_t> read_values(byte_reader& reader, const uint64_t capacity, const char* name) {
+  std::vector<value_t> values(read_size(reader, capacity, name));
+  for (value_t& value : values) {
+    read_element(reader, value);
+  }
+  return values;
+}
+
+static reg_t read_register(byte_reader& reader, const machine_config& config) {
+  reg_t reg {};
+  read_element(reader, reg);
+  if (reg >= config.physical_register_file_size) {
+    throw format_error("physical register out of range");
+  }
+  return reg;
+}
+
+static void check_opcode(const opcode op) {
+  if (static_cast<uint64_t>(op) > static_cast<uint64_t>(opcode::bgeu)) {
+    throw format_error("invalid opcode");
+  }
+}
+
+void write_checkpoint(std::ostream& os, const machine_config& config, const uint64_t cycle,
+  const decoded_program_t& program, const processor_state& state) {
+  std::string buffer;
+  byte_writer writer(buffer);
+  writer.write_bytes(checkpoint_magic, magic_size);
+  writer.write_u64(checkpoint_version);
+
+  // machine and progress of the simulation
+  writer.write_varint(config.num_alus);
+  writer.write_varint(config.active_list_size);
+  writer.write_varint(config.integer_queue_size);
+  writer.write_varint(config.physical_register_file_size);
+  writer.write_varint(config.max_commit_instructions);
+  writer.write_varint(config.max_decode_instructions);
+  writer.write_varint(config.load_store_queue_size);
+  writer.write_varint(config.add_latency);
+  writer.write_varint(config.mulu_latency);
+  writer.write_varint(config.mulu_initiation_interval);
+  writer.write_varint(config.divu_latency);
+  writer.write_varint(config.divu_initiation_interval);
+  writer.write_varint(config.map_checkpoints);
+  for (const uint32_t parameter : {config.cache_line_words, config.l1_sets, config.l1_ways, config.l1_latency,
+      config.l2_sets, config.l2_ways, config.l2_latency, config.memory_latency, config.mshrs,
+      static_cast<uint32_t>(config.cache_replacement_policy), static_cast<uint32_t>(config.branch_predictor),
+      config.predictor_index_bits, config.predictor_history_length, static_cast<uint32_t>(config.fetch_policy)}) {
+    writer.write_varint(parameter);
+  }
+  writer.write_varint(cycle);
+  write_list(writer, program);
+
+  // visible state, the decoded instructions being fetched again from the program
+  writer.write_varint(state.pc);
+  write_list(writer, state.physical_register_file);
+  writer.write_varint(state.decoded_pcs.size());
+  for (auto& entry : state.decoded_pcs) {
+    writer.write_varint(entry.first);
+  }
+  writer.write_varint(state.exception_pc);
+  writer.write_varint(state.exception);
+  write_list(writer, state.register_map_table);
+  write_list(writer, state.free_list);
+  write_list(writer, state.busy_bit_table);
+  write_list(writer, state.active_list);
+  write_list(writer, state.integer_queue.in_age_order());
+
+  // non-visible state, the forwarded values being derived from the forward results
+  writer.write_varint(state.has_exception);
+  writer.write_varint(state.active_list.size());
+  for (const auto& entry : state.active_list) {
+    writer.write_varint(entry.dest_register);
+  }
+  for (uint32_t alu_id {0}; alu_id < config.num_alus; ++alu_id) {
+    write_list(writer, state.alu_queues[alu_id]);
+    write_list(writer, state.alu_results[alu_id]);
+    write_list(writer, state.alu_pipelines[alu_id]);
+    writer.write_varint(state.alu_issue_delays[alu_id]);
+  }
+  write_list(writer, state.alu_forward_results);
+  write_list(writer, state.map_checkpoints);
+  write_list(writer, state.load_store_queue);
+  write_list(writer, state.memory_accesses);
+  write_list(writer, state.load_store_result);
+  const auto memory_words {state.memory.words()};
+  writer.write_varint(memory_words.size());
+  for (const auto& [address, value] : memory_words) {
+    writer.write_varint(address);
+    writer.write_varint(value);
+  }
+  for (const cache_level* level : {&state.caches.l1, &state.caches.l2}) {
+    write_list(writer, level->tags());
+    write_list(writer, level->valid_ways());
+    write_list(writer, level->replacement_state());
+  }
+  write_list(writer, state.caches.mshrs);
+  write_list(writer, state.branches);
+  writer.write_varint(state.branch_history);
+  writer.write_varint(state.misprediction_rollback);
+  write_list(writer, state.predictor.counters());
+  write_list(writer, state.predictor.tagged_entries());
+
+  // performance counters, so that a resumed simulation reports the whole run
+  const perf_counters_t& counters {state.counters};
+  for (const uint64_t counter : {counters.cycles, counters.rollback_cycles, counters.exceptions,
+      counters.rolled_back_instructions, counters.map_checkpoint_recoveries, counters.decoded_instructions,
+      counters.decode_stall_cycles, counters.renamed_instructions, counters.rename_stall_active_list_full,
+      counters.rename_stall_integer_queue_full, counters.rename_stall_load_store_queue_full,
+      counters.rename_stall_free_list_empty, counters.issued_instructions, counters.executed_loads,
+      counters.executed_stores, counters.store_to_load_forwards, counters.memory_order_stall_cycles,
+      counters.load_latency_cycles, counters.mshr_full_stall_cycles, counters.l1_hits, counters.l1_misses,
+      counters.mshr_merges, counters.l1_store_hits, counters.l1_store_misses, counters.l2_hits, counters.l2_misses,
+      counters.branches, counters.mispredicted_branches, counters.misprediction_cycles,
+      counters.misprediction_rollback_cycles, counters.committed_instructions}) {
+    writer.write_varint(counter);
+  }
+  write_list(writer, counters.integer_queue_occupancy);
+  write_list(writer, counters.alu_busy_cycles);
+  write_list(writer, counters.commit_width_histogram);
+
+  os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+checkpoint_t read_checkpoint(std::istream& is) {
+  const std::string buffer {std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()};
+  if (buffer.compare(0, magic_size, checkpoint_magic) != 0) {
+    throw format_error("not a checkpoint");
+  }
+  byte_reader reader(buffer.data() + magic_size, buffer.data() + buffer.size());
+  if (reader.read_u64() != checkpoint_version) {
+    throw format_error("unsupported checkpoint version");
+  }
+
+  // machine and progress of the simulation
+  checkpoint_t checkpoint;
+  machine_config& config {checkpoint.config};
+  read_element(reader, config.num_alus);
+  read_element(reader, config.active_list_size);
+  read_element(reader, config.integer_queue_size);
+  read_element(reader, config.physical_register_file_size);
+  read_element(reader, config.max_commit_instructions);
+  read_element(reader, config.max_decode_instructions);
+  read_element(reader, config.load_store_queue_size);
+  read_element(reader, config.add_latency);
+  read_element(reader, config.mulu_latency);
+  read_element(reader, config.mulu_initiation_interval);
+  read_element(reader, config.divu_latency);
+  read_element(reader, config.divu_initiation_interval);
+  read_element(reader, config.map_checkpoints);
+  for (uint32_t* parameter : {&config.cache_line_words, &config.l1_sets, &config.l1_ways, &config.l1_latency,
+      &config.l2_sets, &config.l2_ways, &config.l2_latency, &config.memory_latency, &config.mshrs}) {
+    read_element(reader, *parameter);
+  }
+  read_element(reader, config.cache_replacement_policy);
+  read_element(reader, config.branch_predictor);
+  read_element(reader, config.predictor_index_bits);
+  read_element(reader, config.predictor_history_length);
+  read_element(reader, config.fetch_policy);
+  try {
+    validate_config(config);
+  } catch (const config_error& e) {
+    throw format_error(std::string {"invalid machine: "} + e.what());
+  }
+  read_element(reader, checkpoint.cycle);
+  checkpoint.program.resize(read_size(reader, max_program_size, "program"));
+  for (auto& instruction : checkpoint.program) {
+    read_element(reader, instruction);
+    check_opcode(instruction.op);
+    if (instruction.dest >= logical_register_file_size || instruction.op_a >= logical_register_file_size
+      || instruction.op_b >= logical_register_file_size) {
+      throw format_error("logical register out of range");
+    }
+  }
+
+  // visible state
+  processor_state& state {checkpoint.state};
+  state = processor_state(config);
+  read_element(reader, state.pc);
+  if (reader.read_varint() != config.physical_register_file_size) {
+    throw format_error("physical register file does not match the machine");
+  }
+  for (auto& value : state.physical_register_file) {
+    read_element(reader, value);
+  }
+  const uint64_t num_decoded {read_size(reader, config.max_decode_instructions, "decoded instructions")};
+  for (uint64_t i {0}; i < num_decoded; ++i) {
+    pc_t pc {};
+    read_element(reader, pc);
+    if (pc >= checkpoint.program.size()) {
+      throw format_error("decoded pc out of the program");
+    }
+    state.decoded_pcs.push_back({pc, checkpoint.program[pc]});
+  }
+  read_element(reader, state.exception_pc);
+  read_element(reader, state.exception);
+  if (reader.read_varint() != logical_register_file_size) {
+    throw format_error("register map table does not match the machine");
+  }
+  for (auto& reg : state.register_map_table) {
+    reg = read_register(reader, config);
+  }
+  state.free_list.clear();
+  const uint64_t num_free {read_size(reader, config.physical_register_file_size, "free list")};
+  for (uint64_t i {0}; i < num_free; ++i) {
+    state.free_list.push_back(read_register(reader, config));
+  }
+  if (reader.read_varint() != config.physical_register_file_size) {
+    throw format_error("busy bit table does not match the machine");
+  }
+  for (size_t i {0}; i < state.busy_bit_table.size(); ++i) {
+    bool busy {};
+    read_element(reader, busy);
+    state.busy_bit_table[i] = busy;
+  }
+  const uint64_t num_active {read_size(reader, config.active_list_size, "active list")};
+  for (uint64_t i {0}; i < num_active; ++i) {
+    active_list_entry_t entry {};
+    read_element(reader, entry);
+    if (entry.logical_destination >= logical_register_file_size
+      || entry.old_destination >= config.physical_register_file_size) {
+      throw format_error("active list register out of range");
+    }
+    state.active_list.push_back(entry);
+  }
+  const uint64_t num_queued {read_size(reader, config.integer_queue_size, "integer queue")};
+  for (uint64_t i {0}; i < num_queued; ++i) {
+    integer_queue_entry_t entry {};
+    read_element(reader, entry);
+    check_opcode(entry.op);
+    if (entry.dest_register >= config.physical_register_file_size
+      || entry.op_a_reg_tag >= config.physical_register_file_size
+      || entry.op_b_reg_tag >= config.physical_register_file_size) {
+      throw format_error("integer queue register out of range");
+    }
+    state.integer_queue.push_back(entry);
+  }
+
+  // non-visible state
+  read_element(reader, state.has_exception);
+  if (reader.read_varint() != state.active_list.size()) {
+    throw format_error("active list destinations do not match the active list");
+  }
+  for (auto& entry : state.active_list) {
+    entry.dest_register = read_register(reader, config);
+  }
+  for (uint32_t alu_id {0}; alu_id < config.num_alus; ++alu_id) {
+    if (read_size(reader, 1, "ALU queue") != 0) {
+      alu_queue_entry_t entry {};
+      read_element(reader, entry);
+      check_opcode(entry.op);
+      if (entry.dest_register >= config.physical_register_file_size) {
+        throw format_error("ALU queue register out of range");
+      }
+      state.alu_queues[alu_id].push_back(entry);
+    }
+    if (read_size(reader, 1, "ALU result") != 0) {
+      alu_result_t result {};
+      read_element(reader, result);
+      if (result.dest_register >= config.physical_register_file_size) {
+        throw format_error("ALU result register out of range");
+      }
+      state.alu_results[alu_id].push_back(result);
+    }
+    // the countdowns of the instructions in execution are strictly increasing and within the latency bound
+    const uint64_t num_executing {read_size(reader, alu_latency_limit, "ALU pipeline")};
+    for (uint64_t i {0}; i < num_executing; ++i) {
+      alu_stage_t stage {};
+      read_element(reader, stage);
+      if (stage.result.dest_register >= config.physical_register_file_size) {
+        throw format_error("ALU pipeline register out of range");
+      }
+      if (stage.cycles_left == 0 || stage.cycles_left > alu_latency_limit
+        || (i != 0 && stage.cycles_left <= state.alu_pipelines[alu_id].back().cycles_left)) {
+        throw format_error("invalid ALU pipeline countdown");
+      }
+      state.alu_pipelines[alu_id].push_back(stage);
+    }
+    read_element(reader, state.alu_issue_delays[alu_id]);
+    if (state.alu_issue_delays[alu_id] > alu_latency_limit) {
+      throw format_error("invalid ALU initiation delay");
+    }
+  }
+  // one result per ALU and one of the load/store unit
+  const uint64_t num_forwarded {read_size(reader, config.num_alus + 1, "forwarding path")};
+  for (uint64_t i {0}; i < num_forwarded; ++i) {
+    alu_result_t result {};
+    read_element(reader, result);
+    if (result.dest_register >= config.physical_register_file_size) {
+      throw format_error("forwarded register out of range");
+    }
+    state.alu_forward_results.push_back(result);
+    if (!result.exception) {
+      state.forwarded_values[result.dest_register] = result.result;
+    }
+  }
+
+  const uint64_t num_map_checkpoints {read_size(reader, config.map_checkpoints, "map checkpoints")};
+  for (uint64_t i {0}; i < num_map_checkpoints; ++i) {
+    map_checkpoint_t checkpoint {};
+    read_element(reader, checkpoint);
+    if (checkpoint.dest_register >= config.physical_register_file_size) {
+      throw format_error("map checkpoint register out of range");
+    }
+    for (const reg_t reg : checkpoint.register_map_table) {
+      if (reg >= config.physical_register_file_size) {
+        throw format_error("map checkpoint register out of range");
+      }
+    }
+    state.map_checkpoints.push_back(checkpoint);
+  }
+  const uint64_t num_loads_stores {read_size(reader, config.load_store_queue_size, "load/store queue")};
+  for (uint64_t i {0}; i < num_loads_stores; ++i) {
+    load_store_queue_entry_t entry {};
+    read_element(reader, entry);
+    if (!is_memory_op(entry.op)) {
+      throw format_error("load/store queue entry is not a load or a store");
+    }
+    if (entry.dest_register >= config.physical_register_file_size
+      || entry.base_reg_tag >= config.physical_register_file_size
+      || entry.data_reg_tag >= config.physical_register_file_size) {
+      throw format_error("load/store queue register out of range");
+    }
+    state.load_store_queue.push_back(entry);
+  }
+  // an access takes at most a miss in both caches, and is one of the entries of the queue
+  const uint32_t max_access_latency {config.l1_latency + config.l2_latency + config.memory_latency};
+  const uint64_t num_accesses {read_size(reader, config.load_store_queue_size, "memory accesses")};
+  for (uint64_t i {0}; i < num_accesses; ++i) {
+    alu_stage_t access {};
+    read_element(reader, access);
+    if (access.result.dest_register >= config.physical_register_file_size) {
+      throw format_error("memory access register out of range");
+    }
+    if (access.cycles_left >= max_access_latency) {
+      throw format_error("invalid memory access countdown");
+    }
+    state.memory_accesses.push_back(access);
+  }
+  if (read_size(reader, 1, "load/store result") != 0) {
+    alu_result_t result {};
+    read_element(reader, result);
+    if (result.dest_register >= config.physical_register_file_size) {
+      throw format_error("load/store result register out of range");
+    }
+    state.load_store_result.push_back(result);
+  }
+  const uint64_t num_words {reader.read_varint()};
+  for (uint64_t i {0}; i < num_words; ++i) {
+    const uint64_t address {reader.read_varint()};
+    state.memory.write(address, reader.read_varint());
+  }
+  for (cache_level* level : {&state.caches.l1, &state.caches.l2}) {
+    const uint64_t num_lines {level->tags().size()};
+    const auto tags {read_values<uint64_t>(reader, num_lines, "cache tags")};
+    const auto valid {read_values<uint16_t>(reader, num_lines, "cache valid ways")};
+    const auto replacement {read_values<uint64_t>(reader, num_lines, "cache replacement state")};
+    if (!level->restore(tags, valid, replacement)) {
+      throw format_error("cache does not match the machine");
+    }
+  }
+  const uint64_t num_mshrs {read_size(reader, config.mshrs, "MSHRs")};
+  for (uint64_t i {0}; i < num_mshrs; ++i) {
+    mshr_t mshr {};
+    read_element(reader, mshr);
+    if (mshr.cycles_left == 0 || mshr.cycles_left > max_access_latency) {
+      throw format_error("invalid MSHR countdown");
+    }
+    state.caches.mshrs.push_back(mshr);
+  }
+  const uint64_t num_branches {read_size(reader, state.branches.capacity(), "branch queue")};
+  for (uint64_t i {0}; i < num_branches; ++i) {
+    branch_queue_entry_t branch {};
+    read_element(reader, branch);
+    if (branch.pc >= checkpoint.program.size() || !is_branch(checkpoint.program[branch.pc].op)) {
+      throw format_error("branch queue entry is not a branch of the program");
+    }
+    if (branch.dest_register >= config.physical_register_file_size) {
+      throw format_error("branch queue register out of range");
+    }
+    state.branches.push_back(branch);
+  }
+  read_element(reader, state.branch_history);
+  read_element(reader, state.misprediction_rollback);
+  const auto predictor_counters {read_values<uint8_t>(reader, state.predictor.counters().size(),
+    "predictor counters")};
+  const auto tagged_entries {read_values<tage_entry_t>(reader, state.predictor.tagged_entries().size(),
+    "predictor tagged entries")};
+  if (!state.predictor.restore(predictor_counters, tagged_entries)) {
+    throw format_error("branch predictor does not match the machine");
+  }
+
+  // performance counters
+  perf_counters_t& counters {state.counters};
+  for (uint64_t* counter : {&counters.cycles, &counters.rollback_cycles, &counters.exceptions,
+      &counters.rolled_back_instructions, &counters.map_checkpoint_recoveries, &counters.decoded_instructions,
+      &counters.decode_stall_cycles, &counters.renamed_instructions, &counters.rename_stall_active_list_full,
+      &counters.rename_stall_integer_queue_full, &counters.rename_stall_load_store_queue_full,
+      &counters.rename_stall_free_list_empty, &counters.issued_instructions, &counters.executed_loads,
+      &counters.executed_stores, &counters.store_to_load_forwards, &counters.memory_order_stall_cycles,
+      &counters.load_latency_cycles, &counters.mshr_full_stall_cycles, &counters.l1_hits, &counters.l1_misses,
+      &counters.mshr_merges, &counters.l1_store_hits, &counters.l1_store_misses, &counters.l2_hits,
+      &counters.l2_misses, &counters.branches, &counters.mispredicted_branches, &counters.misprediction_cycles,
+      &counters.misprediction_rollback_cycles, &counters.committed_instructions}) {
+    read_element(reader, *counter);
+  }
+  for (std::vector<uint64_t>* histogram : {&counters.integer_queue_occupancy, &counters.alu_busy_cycles,
+      &counters.commit_width_histogram}) {
+    if (reader.read_varint() != histogram->size()) {
+      throw format_error("performance counters do not match the machine");
+    }
+    for (uint64_t& value : *histogram) {
+      read_element(reader, value);
+    }
+  }
+
+  if (!reader.at_end()) {
+    throw format_error("unexpected data after the checkpoint");
+  }
+  return checkpoint;
+}
@@ -0,0 +1,35 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include "common.h"
+#include "machine_config.h"
+#include "processor_state.h"
+
+/* Complete snapshot of a simulation, from which it can be resumed exactly:
+ * the machine, the number of simulated cycles, the decoded program and the
+ * processor state, including its non-visible latches and its counters. The file is the
+ * "OOOCHKPT" magic and a version followed by these fields, with integers
+ * encoded as LEB128 variable-length integers. The integer queue is stored in
+ * age order, which is all its selection logic depends on.
+ */
+struct checkpoint_t {
+  machine_config config;
+  uint64_t cycle {0};
+  decoded_program_t program;
+  processor_state state;
+};
+
+void write_checkpoint(std::ostream& os, const machine_config& config, uint64_t cycle,
+  const decoded_program_t& program, const processor_state& state);
+
+// reads a checkpoint, throwing a format_error if it is malformed or inconsistent with its machine
+checkpoint_t read_checkpoint(std::istream& is);
+
+
+
+#endif //CHECKPOINT_H
@@ -0,0 +1,354 @@
+#include "cli_options.h"
+
+#include <charconv>
+#include <iostream>
+#include <vector>
+#include "machine_config.h"
+
+static void print_usage(const char* program_name) {
+  std::cerr << "Usage: " << program_name << " [options] <input file> <output file>\n"
+            << "       " << program_name << " [options] --resume <checkpoint> <output file>\n"
+            << "       " << program_name << " [options] --batch <manifest>\n"
+            << "       " << program_name << " [options] --multicore <manifest>\n"
+            << "Options:\n"
+            << "  --trace-format <format>       json, binary, or none for no output file (default: json)\n"
+            << "  --verbose, -v                 log the activity of every unit in every cycle\n"
+            << "  --batch <manifest>            simulate the input and output files listed on every line of the manifest\n"
+            << "  --multicore <manifest>        simulate the programs listed in the manifest as cores sharing memory\n"
+            << "  --quantum <n>                 cycles the cores run between two synchronizations (default: 1000)\n"
+            << "  --smt-thread <input file>     run the program on another hardware thread next to the input file,\n"
+            << "                                up to 4 threads\n"
+            << "  --fetch-policy <policy>       round_robin or icount thread fetching every cycle (default:\n"
+            << "                                round_robin)\n"
+            << "  --jobs <n>                    threads of the batch and multi-core modes (default: one per hardware\n"
+            << "                                thread)\n"
+            << "  --resume <checkpoint>         resume the simulation saved in a checkpoint, on its machine\n"
+            << "  --checkpoint-every <n>        write a checkpoint to <output file>.<cycle>.ckpt every n cycles\n"
+            << "  --fast-forward <n>            execute the first n instructions on the functional emulator\n"
+            << "  --check                       compare the final state against the functional emulator\n"
+            << "  --cosim                       check every committed instruction against the functional emulator\n"
+            << "  --stats                       write the performance counters to <output file>.stats.json\n"
+            << "  --kanata                      write the pipeline timeline to the Kanata log <output file>.kanata\n"
+            << "  --profile                     print the host time of every unit per simulated cycle to stderr\n"
+            << "  --config <file>               JSON machine description, i.e., {\"num_alus\": 2}\n"
+            << "  --num-alus <n>                number of ALUs (default: 4)\n"
+            << "  --active-list-size <n>        entries of the active list (default: 32)\n"
+            << "  --integer-queue-size <n>      entries of the integer queue (default: 32)\n"
+            << "  --physical-registers <n>      physical registers (default: 64)\n"
+            << "  --commit-width <n>            instructions committed per cycle (default: 4)\n"
+            << "  --decode-width <n>            instructions decoded per cycle (default: 4)\n"
+            << "  --load-store-queue-size <n>   entries of the load/store queue (default: 16)\n"
+            << "  --add-latency <n>             cycles executing add, addi and sub (default: 1)\n"
+            << "  --mulu-latency <n>            cycles executing mulu (default: 1)\n"
+            << "  --mulu-interval <n>           cycles before an ALU starts another instruction after mulu (default: 1)\n"
+            << "  --divu-latency <n>            cycles executing divu and remu (default: 1)\n"
+            << "  --divu-interval <n>           cycles before an ALU starts another instruction after divu and remu\n"
+            << "                                (default: 1)\n"
+            << "  --map-checkpoints <n>         register map checkpoints recovering from an exception or a\n"
+            << "                                mispredicted branch in one cycle, 0 walking the active list back\n"
+            << "                                (default: 0)\n"
+            << "  --cache-line-words <n>        64-bit words per cache line (default: 8)\n"
+            << "  --l1-sets <n>                 sets of the L1 data cache (default: 64)\n"
+            << "  --l1-ways <n>                 ways of the L1 data cache (default: 4)\n"
+            << "  --l1-latency <n>              cycles until a load hitting the L1 gets its data (default: 1)\n"
+            << "  --l2-sets <n>                 sets of the L2 cache (default: 512)\n"
+            << "  --l2-ways <n>                 ways of the L2 cache (default: 8)\n"
+            << "  --l2-latency <n>              cycles the L2 adds to an L1 miss (default: 8)\n"
+            << "  --memory-latency <n>          cycles the memory adds to an L2 miss (default: 50)\n"
+            << "  --mshrs <n>                   L1 misses in flight at once (default: 4)\n"
+            << "  --cache-replacement <policy>  lru or pseudo_lru (default: lru)\n"
+            << "  --predictor <kind>            bimodal, gshare or tage branch predictor (default: gshare)\n"
+            << "  --predictor-index-bits <n>    log2 of the entries of a predictor table (default: 12)\n"
+            << "  --predictor-history <n>       global history bits of the branch predictor (default: 16)\n";
+}
+
+// parses a non-negative integer option value, printing an error if it is malformed
+static std::optional<uint32_t> parse_uint(const std::string& option, const std::string& text) {
+  uint32_t value {0};
+  const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+  if (error != std::errc {} || end != text.data() + text.size()) {
+    std::cerr << "Invalid value for option " << option << ": " << text << std::endl;
+    return std::nullopt;
+  }
+  return value;
+}
+
+// maps the command line flags of the machine parameters to the machine_config fields
+static const char* machine_parameter_name(const std::string& flag) {
+  if (flag == "--num-alus") {
+    return "num_alus";
+  } else if (flag == "--active-list-size") {
+    return "active_list_size";
+  } else if (flag == "--integer-queue-size") {
+    return "integer_queue_size";
+  } else if (flag == "--physical-registers") {
+    return "physical_register_file_size";
+  } else if (flag == "--commit-width") {
+    return "max_commit_instructions";
+  } else if (flag == "--decode-width") {
+    return "max_decode_instructions";
+  } else if (flag == "--load-store-queue-size") {
+    return "load_store_queue_size";
+  } else if (flag == "--add-latency") {
+    return "add_latency";
+  } else if (flag == "--mulu-latency") {
+    return "mulu_latency";
+  } else if (flag == "--mulu-interval") {
+    return "mulu_initiation_interval";
+  } else if (flag == "--divu-latency") {
+    return "divu_latency";
+  } else if (flag == "--divu-interval") {
+    return "divu_initiation_interval";
+  } else if (flag == "--map-checkpoints") {
+    return "map_checkpoints";
+  } else if (flag == "--cache-line-words") {
+    return "cache_line_words";
+  } else if (flag == "--l1-sets") {
+    return "l1_sets";
+  } else if (flag == "--l1-ways") {
+    return "l1_ways";
+  } else if (flag == "--l1-latency") {
+    return "l1_latency";
+  } else if (flag == "--l2-sets") {
+    return "l2_sets";
+  } else if (flag == "--l2-ways") {
+    return "l2_ways";
+  } else if (flag == "--l2-latency") {
+    return "l2_latency";
+  } else if (flag == "--memory-latency") {
+    return "memory_latency";
+  } else if (flag == "--mshrs") {
+    return "mshrs";
+  } else if (flag == "--predictor-index-bits") {
+    return "predictor_index_bits";
+  } else if (flag == "--predictor-history") {
+    return "predictor_history_length";
+  }
+  return nullptr;
+}
+
+std::optional<cli_options> parse_cli_options(int argc, char *argv[]) {
+  cli_options options;
+  std::vector<std::string> positional;
+
+  for (int i {1}; i < argc; ++i) {
+    const std::string arg {argv[i]};
+
+    // returns the value of an option taking an argument, or std::nullopt if it is missing
+    const auto value = [&]() -> std::optional<std::string> {
+      if (i + 1 >= argc) {
+        std::cerr << "Missing value for option: " << arg << std::endl;
+        return std::nullopt;
+      }
+      return std::string {argv[++i]};
+    };
+
+    if (arg == "--trace-format") {
+      const auto format {value()};
+      if (!format) {
+        print_usage(argv[0]);
+        return std::nullopt;
+      }
+      if (*format == "json") {
+        options.output_format = trace_format::json;
+      } else if (*format == "binary") {
+        options.output_format = trace_format::binary;
+      } else if (*format == "none") {
+        options.output_format = trace_format::none;
+      } else {
+        std::cerr << "Unknown trace format: " << *format << std::endl;
+        print_usage(argv[0]);
+        return std::nullopt;
+      }
+    } else if (arg == "--verbose" || arg == "-v") {
+      options.verbose = true;
+    } else if (arg == "--config") {
+      const auto file_name {value()};
+      if (!file_name) {
+        print_usage(argv[0]);
+        return std::nullopt;
+      }
+      options.config_file_name = *file_name;
+    } else if (const char* name {machine_parameter_name(arg)}) {
+      const auto text {value()};
+      const auto parameter {text ? parse_uint(arg, *text) : std::nullopt};
+      if (!parameter) {
+        print_usage(argv[0]);
+        return std::nullopt;
+      }
+      options.machine_parameters.emplace_back(name, *parameter);
+    } else if (arg == "--cache-replacement") {
+      const auto name {value()};
+      const auto policy {name ? parse_cache_replacement(*name) : std::nullopt};
+      if (!policy) {
+        if (name) {
+          std::cerr << "Unknown cache replacement policy: " << *name << std::endl;
+        }
+        print_usage(argv[0]);
+        return std::nullopt;
+      }
+      options.machine_parameters.emplace_back("cache_replacement_policy", static_cast<uint32_t>(*policy));
+    } else if (arg == "--predictor") {
+      const auto name {value()};
+      const auto kind {name ? parse_branch_predictor(*name) : std::nullopt};
+      if (!kind) {
+        if (name) {
+          std::cerr << "Unknown branch predictor: " << *name << std::endl;
+        }
+        print_usage(argv[0]);
+        return std::nullopt;
+      }
+      options.machine_parameters.emplace_back("branch_predictor", static_cast<uint32_t>(*kind));
+    } else if (arg == "--fetch-policy") {
+      const auto name {value()};
+      const auto policy {name ? parse_fetch_policy(*name) : std::nullopt};
+      if (!policy) {
+        if (name) {
+          std::cerr << "Unknown fetch policy: " << *name << std::endl;
+        }
+        print_usage(argv[0]);
+        return std::nullopt;
+      }
+      options.machine_parameters.emplace_back("fetch_policy", static_cast<uint32_t>(*policy));
+    } else if (arg == "--smt-thread") {
+      const auto file_name {value()};
+      if (!file_name) {
+        print_usage(argv[0]);
+        return std::nullopt;
+      }
+      options.thread_file_names.push_back(*file_name);
+    } else if (arg == "--batch") {
+      const auto file_name {value()};
+      if (!file_name) {
+        print_usage(argv[0]);
+        return std::nullopt;
+      }
+      options.batch_file_name = *file_name;
+    } else if (arg == "--multicore") {
+      const auto file_name {value()};
+      if (!file_name) {
+        print_usage(argv[0]);
+        return std::nullopt;
+      }
+      options.multicore_file_name = *file_name;
+    } else if (arg == "--quantum") {
+      const auto text {value()};
+      const auto quantum {text ? parse_uint(arg, *text) : std::nullopt};
+      if (!quantum || *quantum == 0) {
+        if (quantum) {
+          std::cerr << "The quantum must be at least 1 cycle" << std::endl;
+        }
+        print_usage(argv[0]);
+        return std::nullopt;
+      }
+      options.quantum = *quantum;
+    } else if (arg == "--jobs") {
+      const auto text {value()};
+      const auto num_jobs {text ? parse_uint(arg, *text) : std::nullopt};
+      if (!num_jobs) {
+        print_usage(argv[0]);
+        return std::nullopt;
+      }
+      options.num_jobs = *num_jobs;
+    } else if (arg == "--resume") {
+      const auto file_name {value()};
+      if (!file_name) {
+        print_usage(argv[0]);
+        return std::nullopt;
+      }
+      options.resume_file_name = *file_name;
+    } else if (arg == "--checkpoint-every") {
+      const auto text {value()};
+      const auto interval {text ? parse_uint(arg, *text) : std::nullopt};
+      if (!interval) {
+        print_usage(argv[0]);
+        return std::nullopt;
+      }
+      options.checkpoint_interval = *interval;
+    } else if (arg == "--fast-forward") {
+      const auto text {value()};
+      const auto num_instructions {text ? parse_uint(arg, *text) : std::nullopt};
+      if (!num_instructions) {
+        print_usage(argv[0]);
+        return std::nullopt;
+      }
+      options.fast_forward = *num_instructions;
+    } else if (arg == "--check") {
+      options.check = true;
+    } else if (arg == "--cosim") {
+      options.cosim = true;
+    } else if (arg == "--stats") {
+      options.stats = true;
+    } else if (arg == "--kanata") {
+      options.kanata = true;
+    } else if (arg == "--profile") {
+      options.profile = true;
+    } else if (arg.rfind("--", 0) == 0) {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      print_usage(argv[0]);
+      return std::nullopt;
+    } else {
+      positional.push_back(arg);
+    }
+  }
+
+  // the threads of a multithreaded machine share one trace, which only the JSON output and the statistics describe
+  if (!options.thread_file_names.empty()) {
+    if (!options.batch_file_name.empty() || !options.multicore_file_name.empty() || !options.resume_file_name.empty()
+      || options.checkpoint_interval != 0 || options.fast_forward != 0 || options.check || options.cosim
+      || options.kanata || options.output_format == trace_format::binary) {
+      std::cerr << "--batch, --multicore, --resume, --checkpoint-every, --fast-forward, --check, --cosim, --kanata and"
+                << " the binary trace are not supported with --smt-thread" << std::endl;
+      return std::nullopt;
+    }
+  }
+
+  // the multi-core mode takes its input and output files from the manifest, and the cores interact through memory
+  if (!options.multicore_file_name.empty()) {
+    if (!positional.empty() || !options.batch_file_name.empty()) {
+      print_usage(argv[0]);
+      return std::nullopt;
+    }
+    if (options.verbose || options.profile || !options.resume_file_name.empty() || options.checkpoint_interval != 0
+      || options.fast_forward != 0 || options.check || options.cosim) {
+      std::cerr << "--verbose, --profile, --resume, --checkpoint-every, --fast-forward, --check and --cosim are not"
+                << " supported in multi-core mode" << std::endl;
+      return std::nullopt;
+    }
+    return options;
+  }
+
+  // the batch mode takes its input and output files from the manifest
+  if (!options.batch_file_name.empty()) {
+    if (!positional.empty()) {
+      print_usage(argv[0]);
+      return std::nullopt;
+    }
+    if (options.verbose || options.profile || !options.resume_file_name.empty()) {
+      std::cerr << "--verbose, --profile and --resume are not supported in batch mode" << std::endl;
+      return std::nullopt;
+    }
+    return options;
+  }
+
+  // a checkpoint holds its program and machine, so it replaces the input file and the machine options
+  if (!options.resume_file_name.empty()) {
+    if (!options.config_file_name.empty() || !options.machine_parameters.empty()) {
+      std::cerr << "The machine of a checkpoint cannot be changed when resuming it" << std::endl;
+      return std::nullopt;
+    }
+    if (positional.size() != 1) {
+      print_usage(argv[0]);
+      return std::nullopt;
+    }
+    options.output_file_name = positional[0];
+    return options;
+  }
+  if (positional.size() != 2) {
+    print_usage(argv[0]);
+    return std::nullopt;
+  }
+  options.input_file_name = positional[0];
+  options.output_file_name = positional[1];
+  return options;
+}
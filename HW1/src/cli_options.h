@@ -0,0 +1,54 @@
+#ifndef CLI_OPTIONS_H
+#define CLI_OPTIONS_H
+
+
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum class trace_format {
+  json,
+  binary,
+  none, // no output file, which lets the simulator skip the idle cycles
+};
+
+struct cli_options {
+  std::string input_file_name;
+  std::string output_file_name;
+  // programs of the other hardware threads of a simultaneously multithreaded machine running the input file
+  std::vector<std::string> thread_file_names;
+  trace_format output_format {trace_format::json};
+  bool verbose {false};
+  // JSON machine description, if any, and the machine parameters overriding it, by machine_config field name
+  std::string config_file_name;
+  std::vector<std::pair<std::string, uint32_t>> machine_parameters;
+  // manifest of the batch mode, and its number of threads, 0 meaning one per hardware thread
+  std::string batch_file_name;
+  uint32_t num_jobs {0};
+  // manifest of the multi-core mode, with one core per line, and the cycles between the synchronizations of the cores
+  std::string multicore_file_name;
+  uint32_t quantum {1000};
+  // checkpoint to resume from, which replaces the input file, and the interval between checkpoints, 0 meaning none
+  std::string resume_file_name;
+  uint32_t checkpoint_interval {0};
+  // instructions executed on the functional emulator first, and whether to check the result or every commit against it
+  uint32_t fast_forward {0};
+  bool check {false};
+  bool cosim {false};
+  // write the performance counters next to the output file
+  bool stats {false};
+  // write the lifecycle of every instruction to a Kanata log next to the output file
+  bool kanata {false};
+  // print the host time of every unit at the end of the run
+  bool profile {false};
+};
+
+// parses the command line, printing the usage and returning std::nullopt if the arguments are invalid
+std::optional<cli_options> parse_cli_options(int argc, char *argv[]);
+
+
+
+#endif //CLI_OPTIONS_H
@@ -1,17 +1,64 @@
 #include "commit_unit.h"
 
-#include <iostream>
+#include <algorithm>
+#include <vector>
+#include "logger.h"
 
-void commit_unit::step(processor_state& state) {
+// removes the entries of a ring buffer for which the predicate holds, keeping the others in order
+template <typename buffer_t, typename predicate_t>
+static void remove_if(buffer_t& buffer, const predicate_t& predicate) {
+  for (size_t i {buffer.size()}; i > 0; --i) {
+    const auto entry {buffer.front()};
+    buffer.pop_front();
+    if (!predicate(entry)) {
+      buffer.push_back(entry);
+    }
+  }
+}
+
+template <typename params_t>
+void commit_unit::step(processor_state& state, const params_t& params) {
+  const uint32_t num_committed_instructions {commit(state, state, 0, params.max_commit_instructions())};
+  state.counters.committed_instructions += num_committed_instructions;
+  state.counters.commit_width_histogram[num_committed_instructions]++;
+  propagate_alu_forwarding_results(state);
+}
+
+template <typename params_t>
+void commit_unit::smt_step(processor_state& state, const uint32_t first_thread, const params_t& params) {
+  uint32_t num_committed_instructions {0};
+  bool is_rolling_back {false};
+  bool is_rolling_back_misprediction {false};
+  for (uint32_t i {0}; i < state.num_threads(); ++i) {
+    const uint32_t id {(first_thread + i) % state.num_threads()};
+    thread_state_t& thread {state.thread(id)};
+    if (thread.exception || thread.misprediction_rollback) {
+      is_rolling_back |= thread.exception;
+      is_rolling_back_misprediction |= thread.misprediction_rollback;
+      rollback(state, thread, params);
+      continue;
+    }
+    num_committed_instructions += commit(state, thread, id,
+      params.max_commit_instructions() - num_committed_instructions);
+  }
+  state.counters.rollback_cycles += is_rolling_back;
+  state.counters.misprediction_rollback_cycles += is_rolling_back_misprediction && !is_rolling_back;
+  state.counters.committed_instructions += num_committed_instructions;
+  state.counters.commit_width_histogram[num_committed_instructions]++;
+  propagate_alu_forwarding_results(state);
+}
+
+uint32_t commit_unit::commit(processor_state& state, thread_state_t& thread, const uint32_t id,
+  const uint32_t max_instructions) {
   // check if there are instructions to commit
   uint32_t num_committed_instructions {0};
 
-  // check if we have results to commit
-  for (auto it {state.active_list.begin()}; it != state.active_list.end();) {
-    auto& active_list_entry = *it;
+  // check if we have results to commit, in order from the head of the active list
+  while (!thread.active_list.empty()) {
+    auto& active_list_entry = thread.active_list.front();
 
     // check if we have committed the maximum number of instructions
-    if (num_committed_instructions >= max_commit_instructions) {
+    if (num_committed_instructions >= max_instructions) {
       break;
     }
 
@@ -22,52 +69,243 @@ void commit_unit::step(processor_state& state) {
 
     // check if we have an exception
     if (active_list_entry.exception) {
-      std::cout << "exception! pc: " << active_list_entry.pc << "\n";
-      state.has_exception = true;
-      state.exception = true;
-      state.exception_pc = active_list_entry.pc;
-      state.pc = exception_pc_addr;
+      if (m_checker != nullptr) {
+        m_checker->check_exception(state);
+      }
+      LOG_DEBUG("exception! pc: " << active_list_entry.pc << "\n");
+      state.counters.exceptions++;
+      thread.has_exception = true;
+      thread.exception = true;
+      thread.exception_pc = active_list_entry.pc;
+      thread.pc = exception_pc_addr;
+      // a single thread lets every unit clear its own latches on the exception, and the other threads keep theirs
+      if (!state.threads.empty()) {
+        squash_thread(state, thread, id);
+      }
       break;
     }
 
     // commit the instruction
+    if (m_checker != nullptr) {
+      m_checker->check_commit(state);
+    }
+    RECORD_PIPELINE_EVENT(m_recorder, on_commit(active_list_entry.pc, active_list_entry.dest_register));
+    // loads and stores leave the load/store queue in order, the stores writing the caches and the memory
+    if (!thread.load_store_queue.empty() && thread.load_store_queue.front().pc == active_list_entry.pc) {
+      const load_store_queue_entry_t& load_store_entry {thread.load_store_queue.front()};
+      if (load_store_entry.op == opcode::st) {
+        state.caches.store(load_store_entry.address, state.counters);
+        state.memory.write(load_store_entry.address, load_store_entry.data_value);
+      }
+      thread.load_store_queue.pop_front();
+    }
     state.free_list.push_back(active_list_entry.old_destination);
-    it = std::next(it);
-    state.active_list.pop_front();
+    const reg_t dest_register {active_list_entry.dest_register};
+    thread.active_list.pop_front();
     num_committed_instructions++;
+
+    // branches leave the branch queue in order, and squash the younger instructions if they were mispredicted
+    if (!thread.branches.empty() && thread.branches.front().is_renamed
+      && thread.branches.front().dest_register == dest_register) {
+      const branch_queue_entry_t branch {thread.branches.front()};
+      thread.branches.pop_front();
+      if (commit_branch(state, thread, id, branch)) {
+        break;
+      }
+    }
+    if (!thread.map_checkpoints.empty() && thread.map_checkpoints.front().dest_register == dest_register) {
+      thread.map_checkpoints.pop_front();
+    }
   }
-  propagate_alu_forwarding_results(state);
+  if (!state.counters.thread_committed_instructions.empty()) {
+    state.counters.thread_committed_instructions[id] += num_committed_instructions;
+  }
+  return num_committed_instructions;
 }
 
-void commit_unit::exception_step(processor_state& state) {
-  if (!state.exception) {
-    std::cerr << "Error: exception_step called without an exception\n";
+template <typename params_t>
+void commit_unit::exception_step(processor_state& state, const params_t& params) {
+  if (!state.exception && !state.misprediction_rollback) {
+    LOG_ERROR("Error: exception_step called without an exception\n");
     return;
   }
+  if (state.exception) {
+    state.counters.rollback_cycles++;
+  } else {
+    state.counters.misprediction_rollback_cycles++;
+  }
+  rollback(state, state, params);
+}
+
+template <typename params_t>
+void commit_unit::rollback(processor_state& state, thread_state_t& thread, const params_t& params) {
+  if (thread.misprediction_rollback) {
+    state.counters.misprediction_cycles++;
+  }
 
-  if (state.active_list.empty()) {
+  // restore the map in one cycle if the excepting instruction has a checkpoint, and walk the active list back otherwise
+  if (thread.exception && !thread.active_list.empty() && !thread.map_checkpoints.empty()
+    && thread.map_checkpoints.front().dest_register == thread.active_list.front().dest_register) {
+    recover_from_map_checkpoint(state, thread);
+    state.counters.map_checkpoint_recoveries++;
+    thread.exception = false;
+    return;
+  }
+  if (thread.active_list.empty()) {
     // return back to normal state because the active list is empty
-    state.exception = false;
+    thread.exception = false;
   }
 
-  for (uint32_t i {0}; !state.active_list.empty() && i < max_commit_instructions; ++i) {
-    auto& active_list_entry {state.active_list.back()};
+  for (uint32_t i {0}; !thread.active_list.empty() && i < params.max_commit_instructions(); ++i) {
+    auto& active_list_entry {thread.active_list.back()};
 
-    reg_t cur_destination {state.register_map_table.at(active_list_entry.logical_destination)};
+    reg_t cur_destination {thread.register_map_table.at(active_list_entry.logical_destination)};
     reg_t old_destination {active_list_entry.old_destination};
 
     // put back the current destination to the free list
     state.free_list.push_back(cur_destination);
 
     // restore the old destination
-    state.register_map_table.at(active_list_entry.logical_destination) = old_destination;
+    thread.register_map_table.at(active_list_entry.logical_destination) = old_destination;
 
     // restore the busy bit
     state.busy_bit_table.at(cur_destination) = false;
 
     // remove the entry from the active list
-    state.active_list.pop_back();
+    RECORD_PIPELINE_EVENT(m_recorder, on_squash(active_list_entry.pc, active_list_entry.dest_register));
+    thread.active_list.pop_back();
+    state.counters.rolled_back_instructions++;
+  }
+
+  // the wrong path of a mispredicted branch is gone as soon as the active list is empty
+  if (thread.misprediction_rollback && thread.active_list.empty()) {
+    thread.misprediction_rollback = false;
+  }
+}
+
+bool commit_unit::commit_branch(processor_state& state, thread_state_t& thread, const uint32_t id,
+  const branch_queue_entry_t& branch) {
+  state.counters.branches++;
+  state.predictor.update(branch.pc, branch.history, branch.taken);
+  const pc_t next_pc {branch.taken ? branch.target : branch.pc + 1};
+  const pc_t predicted_pc {branch.predicted_taken ? branch.target : branch.pc + 1};
+  if (next_pc == predicted_pc) {
+    return false;
+  }
+
+  // fetch again from the correct pc, with the history the branch should have left
+  LOG_DEBUG("mispredicted branch! pc: " << branch.pc << ", next pc: " << next_pc << "\n");
+  state.counters.mispredicted_branches++;
+  state.counters.misprediction_cycles += state.counters.cycles - branch.fetch_cycle;
+  thread.pc = next_pc;
+  thread.branch_history = state.predictor.next_history(branch.history, branch.taken);
+
+  // every instruction of the thread left in the pipeline is on the wrong path
+  if (state.threads.empty()) {
+    for (auto& entry : state.decoded_pcs) {
+      RECORD_PIPELINE_EVENT(m_recorder, on_squash_decoded(entry.first));
+    }
+    state.decoded_pcs.clear();
+    state.integer_queue.clear();
+    for (size_t alu_id {0}; alu_id < state.alu_queues.size(); ++alu_id) {
+      state.alu_queues[alu_id].clear();
+      state.alu_results[alu_id].clear();
+      state.alu_pipelines[alu_id].clear();
+      state.alu_issue_delays[alu_id] = 0;
+    }
+    state.load_store_queue.clear();
+    state.memory_accesses.clear();
+    state.load_store_result.clear();
+    state.branches.clear();
+  } else {
+    squash_thread(state, thread, id);
+  }
+
+  // restore the map in one cycle if the branch has a checkpoint, and walk the active list back otherwise
+  if (!thread.map_checkpoints.empty() && thread.map_checkpoints.front().dest_register == branch.dest_register) {
+    recover_from_map_checkpoint(state, thread);
+  } else {
+    thread.map_checkpoints.clear();
+    thread.misprediction_rollback = !thread.active_list.empty();
+  }
+  return true;
+}
+
+void commit_unit::squash_thread(processor_state& state, thread_state_t& thread, const uint32_t id) {
+  for (auto& entry : thread.decoded_pcs) {
+    RECORD_PIPELINE_EVENT(m_recorder, on_squash_decoded(entry.first));
+  }
+  thread.decoded_pcs.clear();
+  thread.branches.clear();
+  thread.load_store_queue.clear();
+
+  // the instructions in flight are those whose destination the thread allocated
+  const auto is_squashed = [&state, id](const reg_t reg) { return state.register_threads[reg] == id; };
+  integer_queue_t::slot_mask_t slots {0};
+  for (integer_queue_t::slot_mask_t valid {state.integer_queue.valid_mask()}; valid != 0; valid &= valid - 1) {
+    const uint32_t slot = __builtin_ctz(valid);
+    if (is_squashed(state.integer_queue[slot].dest_register)) {
+      slots |= integer_queue_t::slot_mask_t {1} << slot;
+    }
+  }
+  state.integer_queue.squash(slots);
+  for (size_t alu_id {0}; alu_id < state.alu_queues.size(); ++alu_id) {
+    remove_if(state.alu_queues[alu_id], [&](const alu_queue_entry_t& entry) {
+      return is_squashed(entry.dest_register);
+    });
+    remove_if(state.alu_results[alu_id], [&](const alu_result_t& result) {
+      return is_squashed(result.dest_register);
+    });
+    remove_if(state.alu_pipelines[alu_id], [&](const alu_stage_t& stage) {
+      return is_squashed(stage.result.dest_register);
+    });
+    // an ALU left without instructions can start the next one right away
+    if (state.alu_queues[alu_id].empty() && state.alu_pipelines[alu_id].empty()) {
+      state.alu_issue_delays[alu_id] = 0;
+    }
+  }
+  remove_if(state.memory_accesses, [&](const alu_stage_t& access) {
+    return is_squashed(access.result.dest_register);
+  });
+  remove_if(state.load_store_result, [&](const alu_result_t& result) {
+    return is_squashed(result.dest_register);
+  });
+
+  // the registers of the thread may be allocated to another thread before the forwarding path is cleared
+  for (const auto& alu_result : state.alu_forward_results) {
+    if (is_squashed(alu_result.dest_register)) {
+      state.forwarded_values.at(alu_result.dest_register).reset();
+    }
+  }
+  state.alu_forward_results.erase(std::remove_if(state.alu_forward_results.begin(), state.alu_forward_results.end(),
+    [&](const alu_result_t& result) { return is_squashed(result.dest_register); }), state.alu_forward_results.end());
+}
+
+void commit_unit::recover_from_map_checkpoint(processor_state& state, thread_state_t& thread) {
+  // the checkpoint of the oldest instruction in flight holds the committed map
+  const map_checkpoint_t& checkpoint {thread.map_checkpoints.front()};
+  std::copy(checkpoint.register_map_table.begin(), checkpoint.register_map_table.end(),
+    thread.register_map_table.begin());
+
+  // the registers allocated to the squashed instructions go back to the free list, lowest first
+  std::vector<reg_t> allocated;
+  for (const auto& entry : thread.active_list) {
+    allocated.push_back(entry.dest_register);
+  }
+  std::sort(allocated.begin(), allocated.end());
+  for (const reg_t reg : allocated) {
+    state.free_list.push_back(reg);
+    state.busy_bit_table[reg] = false;
+  }
+
+  // squash the whole active list at once
+  while (!thread.active_list.empty()) {
+    RECORD_PIPELINE_EVENT(m_recorder,
+      on_squash(thread.active_list.back().pc, thread.active_list.back().dest_register));
+    thread.active_list.pop_back();
+    state.counters.rolled_back_instructions++;
   }
+  thread.map_checkpoints.clear();
 }
 
 void commit_unit::propagate_alu_forwarding_results(processor_state& state) {
@@ -75,22 +313,32 @@ void commit_unit::propagate_alu_forwarding_results(processor_state& state) {
   for (auto& alu_result : state.alu_results) {
     // TODO: we currently remove all alu results from the queue
     if (!alu_result.empty()) {
-      alu_result.pop();
+      alu_result.pop_front();
     }
   }
-  for (auto& active_list_entry : state.active_list) {
-    for (auto& alu_result : state.alu_forward_results) {
-      if (alu_result.pc == active_list_entry.pc) {
-        active_list_entry.done = true;
-        active_list_entry.exception = alu_result.exception;
+  state.load_store_result.clear();
+  for (uint32_t id {0}; id < state.num_threads(); ++id) {
+    for (auto& active_list_entry : state.thread(id).active_list) {
+      for (auto& alu_result : state.alu_forward_results) {
+        if (alu_result.dest_register == active_list_entry.dest_register) {
+          active_list_entry.done = true;
+          RECORD_PIPELINE_EVENT(m_recorder, on_complete(active_list_entry.pc, active_list_entry.dest_register));
+          active_list_entry.exception = alu_result.exception;
 
-        // TODO: Since these are not changing the active list, should we check this elsewhere?
-        if (!alu_result.exception) {
-          state.busy_bit_table.at(alu_result.dest_register) = false;
-          state.physical_register_file.at(alu_result.dest_register) = alu_result.result;
+          // TODO: Since these are not changing the active list, should we check this elsewhere?
+          if (!alu_result.exception) {
+            state.busy_bit_table.at(alu_result.dest_register) = false;
+            state.physical_register_file.at(alu_result.dest_register) = alu_result.result;
+          }
+          break;
         }
-        break;
       }
     }
   }
-}
\ No newline at end of file
+}
+
+#define INSTANTIATE_COMMIT_UNIT(params_t) \
+  template void commit_unit::step(processor_state&, const params_t&); \
+  template void commit_unit::exception_step(processor_state&, const params_t&); \
+  template void commit_unit::smt_step(processor_state&, uint32_t, const params_t&);
+FOR_EACH_MACHINE_PARAMS(INSTANTIATE_COMMIT_UNIT)
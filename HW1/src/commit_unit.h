@@ -3,14 +3,43 @@
 
 
 
+#include "cosim_checker.h"
+#include "machine_params.h"
+#include "pipeline_recorder.h"
 #include "processor_state.h"
 
 class commit_unit {
 public:
-  void step(processor_state& state);
-  void exception_step(processor_state& state);
+  template <typename params_t>
+  void step(processor_state& state, const params_t& params);
+  template <typename params_t>
+  void exception_step(processor_state& state, const params_t& params);
+  /* Commits the hardware threads of a simultaneously multithreaded machine
+   * in turn from first_thread within the shared commit width, and rolls back
+   * the threads which raised an exception or mispredicted a branch meanwhile.
+   * A thread squashes only its own instructions, and the other threads keep
+   * running while it rolls back.
+   */
+  template <typename params_t>
+  void smt_step(processor_state& state, uint32_t first_thread, const params_t& params);
+  // checks every commit against a functional model, or nothing if checker is nullptr
+  void set_checker(cosim_checker* checker) { m_checker = checker; }
+  void set_recorder(pipeline_recorder* recorder) { m_recorder = recorder; }
 private:
+  cosim_checker* m_checker {nullptr};
+  pipeline_recorder* m_recorder {nullptr};
+  // commits at most max_instructions instructions of a thread, returning the number committed
+  uint32_t commit(processor_state& state, thread_state_t& thread, uint32_t id, uint32_t max_instructions);
+  // walks the active list of a thread back by the commit width, or restores a map checkpoint
+  template <typename params_t>
+  void rollback(processor_state& state, thread_state_t& thread, const params_t& params);
   void propagate_alu_forwarding_results(processor_state& state);
+  // trains the predictor with a committed branch, and squashes the wrong path if it was mispredicted
+  bool commit_branch(processor_state& state, thread_state_t& thread, uint32_t id, const branch_queue_entry_t& branch);
+  // removes the instructions of a thread from the structures shared with the other threads
+  void squash_thread(processor_state& state, thread_state_t& thread, uint32_t id);
+  // restores the map of the checkpoint of the oldest instruction in flight, squashing the active list
+  void recover_from_map_checkpoint(processor_state& state, thread_state_t& thread);
 };
 
 
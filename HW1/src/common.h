@@ -1,6 +1,7 @@
 #ifndef COMMON_H
 #define COMMON_H
 
+#include <array>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -14,8 +15,25 @@ enum class opcode {
   mulu,
   divu,
   remu,
+  ld, // ld xd, xa, imm loads the word at address xa + imm into xd
+  st, // st xd, xa, imm stores xd to the word at address xa + imm, and renames xd to a copy of its value
+  // beq xa, xb, imm continues at pc + imm if xa == xb, and renames xa to a copy of its value
+  beq,
+  bne,
+  bltu,
+  bgeu,
 };
 
+// loads and stores go to the load/store queue instead of the integer queue
+inline bool is_memory_op(const opcode op) {
+  return op == opcode::ld || op == opcode::st;
+}
+
+// conditional branches, whose direction is predicted when they are decoded
+inline bool is_branch(const opcode op) {
+  return op == opcode::beq || op == opcode::bne || op == opcode::bltu || op == opcode::bgeu;
+}
+
 // program counter data type
 typedef uint32_t pc_t;
 
@@ -34,12 +52,16 @@ struct instruction_t {
   operand_t imm;
 };
 
+// program decoded ahead of the simulation, indexed by pc
+typedef std::vector<instruction_t> decoded_program_t;
+
 struct active_list_entry_t {
   bool done;
   bool exception;
   reg_t logical_destination;
   reg_t old_destination;
   pc_t pc;
+  reg_t dest_register; // the physical register it writes, which identifies it while in flight
 };
 
 struct integer_queue_entry_t {
@@ -69,12 +91,99 @@ struct alu_result_t {
   pc_t pc;
 };
 
+// a load or a store, in program order in the load/store queue
+struct load_store_queue_entry_t {
+  reg_t dest_register;
+  bool base_is_ready;
+  reg_t base_reg_tag;
+  operand_t base_value;
+  bool data_is_ready; // loads have no data
+  reg_t data_reg_tag;
+  operand_t data_value;
+  operand_t offset;
+  bool address_is_known;
+  operand_t address;
+  bool done; // the load read its value, or the store produced its result
+  opcode op;
+  pc_t pc;
+};
+
+// an instruction executing on an ALU or a memory access in flight, whose result is computed when it starts
+struct alu_stage_t {
+  alu_result_t result;
+  uint32_t cycles_left;
+};
+
+// a conditional branch in flight, in program order from decode to commit
+struct branch_queue_entry_t {
+  pc_t pc;
+  pc_t target;
+  bool predicted_taken;
+  uint64_t history; // global history the branch was predicted with
+  uint64_t fetch_cycle;
+  bool is_renamed;
+  reg_t dest_register; // once renamed
+  bool taken; // once executed
+};
+
+// line chosen for eviction when a set of a cache is full
+enum class cache_replacement : uint32_t {
+  lru,
+  pseudo_lru, // tree of one bit per pair of subtrees, pointing to the least recently used one
+};
+
+// direction predictor of the conditional branches
+enum class branch_predictor_kind : uint32_t {
+  bimodal, // 2-bit counters indexed by the pc
+  gshare, // 2-bit counters indexed by the pc xor the global history
+  tage, // bimodal base and tagged tables of geometrically longer histories
+};
+
+// hardware thread fetching in a cycle on a simultaneously multithreaded machine
+enum class fetch_policy_kind : uint32_t {
+  round_robin, // the threads take turns
+  icount, // the thread with the fewest instructions waiting in the queues
+};
+
+// entry of a tagged table of the TAGE branch predictor
+struct tage_entry_t {
+  uint16_t tag;
+  uint8_t counter; // 3-bit, predicting taken from 4 on
+  uint8_t useful; // 2-bit
+};
+
+// miss status holding register, tracking a line on its way to the L1 cache
+struct mshr_t {
+  uint64_t line;
+  uint32_t cycles_left;
+};
+
 constexpr uint32_t logical_register_file_size = 32;
-constexpr uint32_t physical_register_file_size = 64;
-constexpr uint32_t active_list_size = 32;
-constexpr uint32_t integer_queue_size = 32;
-constexpr uint32_t num_alus {4};
-constexpr uint32_t max_commit_instructions {4};
 constexpr uint32_t exception_pc_addr {0x10000};
 
+// upper bounds of the machine parameters in machine_config, which size the fixed-capacity structures
+constexpr uint32_t physical_register_file_size_limit {256};
+constexpr uint32_t active_list_size_limit {256};
+constexpr uint32_t integer_queue_size_limit {32};
+constexpr uint32_t load_store_queue_size_limit {32};
+constexpr uint32_t num_alus_limit {32};
+constexpr uint32_t max_decode_instructions_limit {16};
+constexpr uint32_t alu_latency_limit {64};
+constexpr uint32_t map_checkpoints_limit {16};
+constexpr uint32_t cache_line_words_limit {64};
+constexpr uint32_t cache_sets_limit {1 << 16};
+constexpr uint32_t cache_ways_limit {16};
+constexpr uint32_t cache_latency_limit {1024};
+constexpr uint32_t mshrs_limit {16};
+constexpr uint32_t predictor_index_bits_limit {20};
+constexpr uint32_t predictor_history_length_limit {64};
+constexpr uint32_t smt_threads_limit {4};
+
+// register map table before renaming an instruction which may raise an exception, or after renaming a branch
+struct map_checkpoint_t {
+  pc_t pc;
+  reg_t dest_register; // of the instruction
+  std::array<reg_t, logical_register_file_size> register_map_table;
+};
+
 #endif //COMMON_H
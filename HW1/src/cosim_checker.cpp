@@ -0,0 +1,96 @@
+#include "cosim_checker.h"
+
+#include <algorithm>
+#include <array>
+#include <sstream>
+#include "decode_unit.h"
+
+cosim_error::cosim_error(const pc_t pc, const std::string& message)
+  : std::runtime_error(message), m_pc(pc) {}
+
+cosim_checker::cosim_checker(const decoded_program_t& program, const processor_state& state)
+  : m_program(program), m_model(program, to_architectural_state(state)) {}
+
+void cosim_checker::check_commit(const processor_state& state) {
+  const active_list_entry_t& entry {state.active_list.front()};
+  if (m_model.get_state().pc != entry.pc) {
+    report(state, entry.pc, false, "committed out of program order, expected pc "
+      + std::to_string(m_model.get_state().pc));
+  }
+
+  // a store writes the memory as it commits, so its address and data are checked before
+  const instruction_t& instr {m_program[entry.pc]};
+  if (instr.op == opcode::st) {
+    const load_store_queue_entry_t& store {state.load_store_queue.front()};
+    const uint64_t address {m_model.get_state().registers[instr.op_a] + instr.imm};
+    const uint64_t data {m_model.get_state().registers[instr.op_b]};
+    if (store.address != address || store.data_value != data) {
+      report(state, entry.pc, false, "stores " + std::to_string(store.data_value) + " to address "
+        + std::to_string(store.address) + ", expected " + std::to_string(data) + " to address "
+        + std::to_string(address));
+    }
+  }
+  m_model.run(1);
+  if (m_model.get_state().has_exception) {
+    report(state, entry.pc, false, "committed an instruction which raises an exception");
+  }
+
+  // the destination is remapped by the first younger instruction writing the same register, if any
+  reg_t physical_destination {state.register_map_table.at(entry.logical_destination)};
+  for (size_t i {1}; i < state.active_list.size(); ++i) {
+    if (state.active_list[i].logical_destination == entry.logical_destination) {
+      physical_destination = state.active_list[i].old_destination;
+      break;
+    }
+  }
+  const uint64_t expected {m_model.get_state().registers[entry.logical_destination]};
+  const uint64_t actual {state.physical_register_file.at(physical_destination)};
+  if (actual != expected) {
+    report(state, entry.pc, true, "x" + std::to_string(entry.logical_destination) + " (p"
+      + std::to_string(physical_destination) + ") is " + std::to_string(actual) + ", expected "
+      + std::to_string(expected));
+  }
+}
+
+void cosim_checker::check_exception(const processor_state& state) {
+  const active_list_entry_t& entry {state.active_list.front()};
+  if (m_model.get_state().pc != entry.pc) {
+    report(state, entry.pc, false, "raised an exception out of program order, expected pc "
+      + std::to_string(m_model.get_state().pc));
+  }
+  m_model.run(1);
+  if (!m_model.get_state().has_exception) {
+    report(state, entry.pc, true, "raised an exception which the functional model does not raise");
+  }
+}
+
+void cosim_checker::report(const processor_state& state, const pc_t pc, const bool head_retired,
+  const std::string& reason) const {
+  std::ostringstream message;
+  message << "co-simulation mismatch at pc " << pc;
+  if (pc < m_program.size()) {
+    message << " (" << decode_unit::disassemble(m_program[pc]) << ")";
+  }
+  message << ": " << reason << '\n';
+
+  // roll the register map table back to the state the model is in
+  std::array<reg_t, logical_register_file_size> committed_map {};
+  for (reg_t i {0}; i < logical_register_file_size; ++i) {
+    committed_map[i] = state.register_map_table.at(i);
+  }
+  const size_t num_retired {head_retired ? 1u : 0u};
+  for (size_t i {state.active_list.size()}; i > num_retired; --i) {
+    committed_map[state.active_list[i - 1].logical_destination] = state.active_list[i - 1].old_destination;
+  }
+
+  // dump the architectural registers of both models, marking the ones which differ
+  const architectural_state_t& expected {m_model.get_state()};
+  message << "register  processor             model\n";
+  for (reg_t i {0}; i < logical_register_file_size; ++i) {
+    const uint64_t actual {state.physical_register_file.at(committed_map[i])};
+    message << (actual != expected.registers[i] ? "* x" : "  x") << i << (i < 10 ? "     " : "    ")
+            << actual << std::string(22 - std::min<size_t>(21, std::to_string(actual).size()), ' ')
+            << expected.registers[i] << (i + 1 < logical_register_file_size ? "\n" : "");
+  }
+  throw cosim_error(pc, message.str());
+}
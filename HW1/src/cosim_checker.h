@@ -0,0 +1,44 @@
+#ifndef COSIM_CHECKER_H
+#define COSIM_CHECKER_H
+
+
+
+#include <stdexcept>
+#include <string>
+#include "common.h"
+#include "functional_emulator.h"
+#include "processor_state.h"
+
+// raised at the first instruction whose committed result differs from the functional model
+class cosim_error : public std::runtime_error {
+public:
+  cosim_error(pc_t pc, const std::string& message);
+  pc_t pc() const { return m_pc; }
+private:
+  pc_t m_pc;
+};
+
+/* Replays every committed instruction on the functional emulator, in
+ * lockstep with the commit stage. After each commit, the value of the
+ * destination register reached through the register map table is compared
+ * against the model, as are the address and the data of a store, and an
+ * exception must be raised by the model at the same pc. The checker starts
+ * from the architectural state of the processor when it is created.
+ */
+class cosim_checker {
+public:
+  cosim_checker(const decoded_program_t& program, const processor_state& state);
+  // checks the instruction at the head of the active list, which is about to commit
+  void check_commit(const processor_state& state);
+  // checks the instruction at the head of the active list, which raised an exception
+  void check_exception(const processor_state& state);
+private:
+  // throws a cosim_error with the registers of both models, the head of the active list being retired or not
+  [[noreturn]] void report(const processor_state& state, pc_t pc, bool head_retired, const std::string& reason) const;
+  decoded_program_t m_program;
+  functional_emulator m_model;
+};
+
+
+
+#endif //COSIM_CHECKER_H
@@ -0,0 +1,30 @@
+#include "data_memory.h"
+
+#include <algorithm>
+
+void data_memory::write(const uint64_t address, const uint64_t value) {
+  if (value == 0) {
+    m_words.erase(address);
+  } else {
+    m_words[address] = value;
+  }
+  if (m_write_log_enabled) {
+    m_write_log.emplace_back(address, value);
+  }
+}
+
+void data_memory::apply(const std::vector<std::pair<uint64_t, uint64_t>>& writes) {
+  for (const auto& [address, value] : writes) {
+    if (value == 0) {
+      m_words.erase(address);
+    } else {
+      m_words[address] = value;
+    }
+  }
+}
+
+std::vector<std::pair<uint64_t, uint64_t>> data_memory::words() const {
+  std::vector<std::pair<uint64_t, uint64_t>> words {m_words.begin(), m_words.end()};
+  std::sort(words.begin(), words.end());
+  return words;
+}
@@ -0,0 +1,41 @@
+#ifndef DATA_MEMORY_H
+#define DATA_MEMORY_H
+
+
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/* Data memory of the programs: 64-bit words indexed by their address, all
+ * zero at the start. Only the words holding a nonzero value are stored, so
+ * that two memories are equal if and only if they hold the same values. The
+ * write log is not part of the value of a memory.
+ */
+class data_memory {
+public:
+  uint64_t read(const uint64_t address) const {
+    const auto it {m_words.find(address)};
+    return it == m_words.end() ? 0 : it->second;
+  }
+  void write(uint64_t address, uint64_t value);
+  // records every write from now on, for take_write_log
+  void enable_write_log() { m_write_log_enabled = true; }
+  // the writes since the last call, in the order they happened
+  std::vector<std::pair<uint64_t, uint64_t>> take_write_log() { return std::exchange(m_write_log, {}); }
+  // writes the words in order without recording them, i.e., the writes of another memory
+  void apply(const std::vector<std::pair<uint64_t, uint64_t>>& writes);
+  // the nonzero words, sorted by address
+  std::vector<std::pair<uint64_t, uint64_t>> words() const;
+  bool operator==(const data_memory& other) const { return m_words == other.m_words; }
+  bool operator!=(const data_memory& other) const { return !(*this == other); }
+private:
+  std::unordered_map<uint64_t, uint64_t> m_words;
+  bool m_write_log_enabled {false};
+  std::vector<std::pair<uint64_t, uint64_t>> m_write_log;
+};
+
+
+
+#endif //DATA_MEMORY_H
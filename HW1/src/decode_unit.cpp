@@ -1,12 +1,24 @@
-#include <iostream>
-#include <sstream>
+#include <charconv>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "decode_unit.h"
+#include "logger.h"
 
-void decode_unit::step(processor_state& state, const program_t& program) {
+program_error::program_error(const pc_t pc, const std::string& instruction, const std::string& reason)
+  : std::runtime_error("line " + std::to_string(pc + 1) + " (pc " + std::to_string(pc) + ") \""
+      + instruction + "\": " + reason),
+    m_pc(pc) {}
+
+template <typename params_t>
+void decode_unit::step(processor_state& state, const decoded_program_t& program, const params_t& params) {
   // check if we are in exception mode - we need to check first otherwise we will never clear the decoded_pcs register
   if (state.exception) {
+    for (auto& entry : state.decoded_pcs) {
+      RECORD_PIPELINE_EVENT(m_recorder, on_squash_decoded(entry.first));
+    }
     state.decoded_pcs.clear();
+    state.branches.clear();
     return;
   }
 
@@ -17,27 +29,129 @@ void decode_unit::step(processor_state& state, const program_t& program) {
 
   // check if the next stage (rename and dispatch stage) is applying backpressure
   if (!state.decoded_pcs.empty()) {
+    state.counters.decode_stall_cycles++;
+    return;
+  }
+  fetch(state, state, program, params);
+}
+
+template <typename params_t>
+void decode_unit::smt_step(processor_state& state, const std::vector<decoded_program_t>& programs,
+  const uint32_t first_thread, const params_t& params) {
+  // the threads rolling back or done fetching are out, and a full latch stalls its thread
+  const uint32_t num_threads {state.num_threads()};
+  uint32_t fetch_id {num_threads};
+  uint32_t fetch_count {0};
+  bool stalled {false};
+  for (uint32_t i {0}; i < num_threads; ++i) {
+    const uint32_t id {(first_thread + i) % num_threads};
+    const thread_state_t& thread {state.thread(id)};
+    if (thread.exception || thread.misprediction_rollback || thread.has_exception
+      || thread.pc >= programs[id].size()) {
+      continue;
+    }
+    if (!thread.decoded_pcs.empty()) {
+      stalled = true;
+      continue;
+    }
+    if (params.fetch_policy() == fetch_policy_kind::round_robin) {
+      fetch_id = id;
+      break;
+    }
+
+    // count the instructions of the thread waiting in the front end and the queues, the first one winning ties
+    uint32_t count {0};
+    for (uint32_t slots {state.integer_queue.valid_mask()}; slots != 0; slots &= slots - 1) {
+      count += state.register_threads[state.integer_queue[__builtin_ctz(slots)].dest_register] == id;
+    }
+    for (const auto& entry : thread.load_store_queue) {
+      count += !entry.done;
+    }
+    if (fetch_id == num_threads || count < fetch_count) {
+      fetch_id = id;
+      fetch_count = count;
+    }
+  }
+  if (fetch_id == num_threads) {
+    state.counters.decode_stall_cycles += stalled;
     return;
   }
+  state.counters.thread_fetch_cycles[fetch_id]++;
+  fetch(state, state.thread(fetch_id), programs[fetch_id], params);
+}
 
-  // fetch the next instructions to decode
-  for (uint32_t i = 0; state.pc < program.size() && i < max_decode_instructions; ++i) {
-    std::cout << "decoding instruction at pc: " << state.pc << '\n';
-    state.decoded_pcs.push_back({
-      state.pc,
-      decode(program[state.pc]),
+template <typename params_t>
+void decode_unit::fetch(processor_state& state, thread_state_t& thread, const decoded_program_t& program,
+  const params_t& params) {
+  // fetch the next instructions, which were decoded when loading the program
+  for (uint32_t i = 0; thread.pc < program.size() && i < params.max_decode_instructions(); ++i) {
+    LOG_DEBUG("decoding instruction at pc: " << thread.pc << '\n');
+    const pc_t pc {thread.pc};
+    const instruction_t& instr {program[pc]};
+    thread.decoded_pcs.push_back({
+      pc,
+      instr,
     });
-    state.pc++;
+    RECORD_PIPELINE_EVENT(m_recorder, on_decode(pc, instr));
+    thread.pc++;
+    state.counters.decoded_instructions++;
+
+    // predict the direction of a branch, fetching from its target in the next cycle if it is predicted taken
+    if (is_branch(instr.op)) {
+      const bool predicted_taken {state.predictor.predict(pc, thread.branch_history)};
+      thread.branches.push_back({
+        .pc =              pc,
+        .target =          static_cast<pc_t>(pc + instr.imm),
+        .predicted_taken = predicted_taken,
+        .history =         thread.branch_history,
+        .fetch_cycle =     state.counters.cycles,
+        .is_renamed =      false,
+        .dest_register =   0,
+        .taken =           false,
+      });
+      thread.branch_history = state.predictor.next_history(thread.branch_history, predicted_taken);
+      if (predicted_taken) {
+        thread.pc = thread.branches.back().target;
+        break;
+      }
+    }
   }
 }
 
-instruction_t decode_unit::decode(const std::string& instruction) {
+decoded_program_t decode_unit::decode_program(const program_t& program) {
+  decoded_program_t decoded_program;
+  decoded_program.reserve(program.size());
+  for (pc_t pc {0}; pc < program.size(); ++pc) {
+    decoded_program.push_back(decode(pc, program[pc]));
+
+    // a branch may target the end of the program, which stops it
+    const instruction_t& instr {decoded_program.back()};
+    const int64_t target {static_cast<int64_t>(pc) + static_cast<int64_t>(instr.imm)};
+    if (is_branch(instr.op) && (target < 0 || target > static_cast<int64_t>(program.size()))) {
+      throw program_error(pc, program[pc], "branch target " + std::to_string(target) + " out of the program");
+    }
+  }
+  return decoded_program;
+}
+
+instruction_t decode_unit::decode(const pc_t pc, const std::string& instruction) {
   instruction_t instr {};
-  std::stringstream ss(instruction);
+
+  // split the instruction into tokens separated by whitespaces and commas, i.e., "addi x1, x2, 3"
+  std::vector<std::string_view> tokens;
+  const std::string_view text {instruction};
+  std::string_view::size_type begin {text.find_first_not_of(" \t,")};
+  while (begin != std::string_view::npos) {
+    const std::string_view::size_type end {text.find_first_of(" \t,", begin)};
+    tokens.push_back(text.substr(begin, end == std::string_view::npos ? end : end - begin));
+    begin = text.find_first_not_of(" \t,", end);
+  }
+  if (tokens.size() != 4) {
+    throw program_error(pc, instruction, "expected an opcode followed by 3 operands");
+  }
 
   // decode the opcode
-  std::string op;
-  ss >> op;
+  const std::string_view op {tokens[0]};
   if (op == "add") {
     instr.op = opcode::add;
   } else if (op == "addi") {
@@ -50,28 +164,126 @@ instruction_t decode_unit::decode(const std::string& instruction) {
     instr.op = opcode::divu;
   } else if (op == "remu") {
     instr.op = opcode::remu;
+  } else if (op == "ld") {
+    instr.op = opcode::ld;
+  } else if (op == "st") {
+    instr.op = opcode::st;
+  } else if (op == "beq") {
+    instr.op = opcode::beq;
+  } else if (op == "bne") {
+    instr.op = opcode::bne;
+  } else if (op == "bltu") {
+    instr.op = opcode::bltu;
+  } else if (op == "bgeu") {
+    instr.op = opcode::bgeu;
+  } else {
+    throw program_error(pc, instruction, "unknown opcode \"" + std::string {op} + "\"");
+  }
+
+  // decodes a register operand, i.e., "x10"
+  const auto decode_register = [&](const std::string_view operand) {
+    uint32_t reg {0};
+    const char* end {operand.data() + operand.size()};
+    if (operand.size() < 2 || operand[0] != 'x'
+        || std::from_chars(operand.data() + 1, end, reg).ptr != end
+        || reg >= logical_register_file_size) {
+      throw program_error(pc, instruction, "invalid register \"" + std::string {operand} + "\"");
+    }
+    return reg;
+  };
+
+  // decodes an immediate value, i.e., "-3"
+  const auto decode_immediate = [&](const std::string_view operand) {
+    int64_t imm {0};
+    const char* end {operand.data() + operand.size()};
+    if (std::from_chars(operand.data(), end, imm).ptr != end) {
+      throw program_error(pc, instruction, "invalid immediate \"" + std::string {operand} + "\"");
+    }
+    return static_cast<operand_t>(imm);
+  };
+
+  // a branch compares its two registers, and renames the first one to a copy of its value like a store
+  if (is_branch(instr.op)) {
+    instr.dest = decode_register(tokens[1]);
+    instr.op_a = instr.dest;
+    instr.op_b = decode_register(tokens[2]);
+    instr.imm = decode_immediate(tokens[3]);
+    return instr;
   }
 
-  // decode the destination, i.e., dest = "x10,"
-  std::string dest;
-  ss >> dest;
-  instr.dest = std::stoi(dest.substr(1));
-
-  // decode the first operand, i.e., op_a = "x1,"
-  std::string op_a;
-  ss >> op_a;
-  instr.op_a = std::stoi(op_a.substr(1));
-
-  // decode the second operand, i.e., op_b = "x2," or an immediate value
-  if (instr.op == opcode::addi) {
-    std::string imm;
-    ss >> imm;
-    instr.imm = std::stoll(imm);
+  // decode the destination and the first operand
+  instr.dest = decode_register(tokens[1]);
+  instr.op_a = decode_register(tokens[2]);
+
+  // decode the second operand, i.e., op_b = "x2" or an immediate value
+  if (instr.op == opcode::addi || instr.op == opcode::ld || instr.op == opcode::st) {
+    instr.imm = decode_immediate(tokens[3]);
+    // a store reads the register it writes
+    if (instr.op == opcode::st) {
+      instr.op_b = instr.dest;
+    }
   } else {
-    std::string op_b;
-    ss >> op_b;
-    instr.op_b = std::stoi(op_b.substr(1));
+    instr.op_b = decode_register(tokens[3]);
   }
 
   return instr;
-}
\ No newline at end of file
+}
+
+std::string decode_unit::disassemble(const instruction_t& instr) {
+  std::string text;
+  switch (instr.op) {
+    case opcode::add:
+      text = "add";
+      break;
+    case opcode::addi:
+      text = "addi";
+      break;
+    case opcode::sub:
+      text = "sub";
+      break;
+    case opcode::mulu:
+      text = "mulu";
+      break;
+    case opcode::divu:
+      text = "divu";
+      break;
+    case opcode::remu:
+      text = "remu";
+      break;
+    case opcode::ld:
+      text = "ld";
+      break;
+    case opcode::st:
+      text = "st";
+      break;
+    case opcode::beq:
+      text = "beq";
+      break;
+    case opcode::bne:
+      text = "bne";
+      break;
+    case opcode::bltu:
+      text = "bltu";
+      break;
+    case opcode::bgeu:
+      text = "bgeu";
+      break;
+  }
+  if (is_branch(instr.op)) {
+    return text + " x" + std::to_string(instr.op_a) + ", x" + std::to_string(instr.op_b) + ", "
+      + std::to_string(static_cast<int64_t>(instr.imm));
+  }
+  text += " x" + std::to_string(instr.dest) + ", x" + std::to_string(instr.op_a) + ", ";
+  if (instr.op == opcode::addi || instr.op == opcode::ld || instr.op == opcode::st) {
+    text += std::to_string(static_cast<int64_t>(instr.imm));
+  } else {
+    text += "x" + std::to_string(instr.op_b);
+  }
+  return text;
+}
+
+#define INSTANTIATE_DECODE_UNIT(params_t) \
+  template void decode_unit::step(processor_state&, const decoded_program_t&, const params_t&); \
+  template void decode_unit::smt_step(processor_state&, const std::vector<decoded_program_t>&, uint32_t, \
+    const params_t&);
+FOR_EACH_MACHINE_PARAMS(INSTANTIATE_DECODE_UNIT)
@@ -3,16 +3,47 @@
 
 
 
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include "common.h"
+#include "machine_params.h"
+#include "pipeline_recorder.h"
 #include "processor_state.h"
 
-const uint32_t max_decode_instructions {4};
+// raised when an instruction of the program cannot be decoded
+class program_error : public std::runtime_error {
+public:
+  program_error(pc_t pc, const std::string& instruction, const std::string& reason);
+  pc_t pc() const { return m_pc; }
+private:
+  pc_t m_pc;
+};
 
 class decode_unit {
 public:
-  void step(processor_state& state, const program_t& program);
+  // decodes the whole program once before the simulation, throwing a program_error on the first malformed line
+  static decoded_program_t decode_program(const program_t& program);
+  template <typename params_t>
+  void step(processor_state& state, const decoded_program_t& program, const params_t& params);
+  /* Fetches the program of one hardware thread of a simultaneously
+   * multithreaded machine, chosen by the fetch policy among the threads whose
+   * latch is empty: in turn from first_thread with round_robin, and with
+   * icount the thread with the fewest instructions waiting in the integer
+   * queue and the load/store queue.
+   */
+  template <typename params_t>
+  void smt_step(processor_state& state, const std::vector<decoded_program_t>& programs, uint32_t first_thread,
+    const params_t& params);
+  // formats a decoded instruction back to its assembly, i.e., "addi x1, x2, 3"
+  static std::string disassemble(const instruction_t& instr);
+  void set_recorder(pipeline_recorder* recorder) { m_recorder = recorder; }
 private:
-  instruction_t decode(const std::string& instruction);
+  pipeline_recorder* m_recorder {nullptr};
+  // fetches the next instructions of a thread into its empty decode latch
+  template <typename params_t>
+  void fetch(processor_state& state, thread_state_t& thread, const decoded_program_t& program, const params_t& params);
+  static instruction_t decode(pc_t pc, const std::string& instruction);
 };
 
 
@@ -1,12 +1,35 @@
 #include "forward_unit.h"
 
-void forward_unit::step(processor_state &state) {
+template <typename params_t>
+void forward_unit::step(processor_state &state, const params_t& params) {
+  // the results forwarded in the previous cycle are no longer on the forwarding path
+  for (auto& alu_result : state.alu_forward_results) {
+    state.forwarded_values.at(alu_result.dest_register).reset();
+  }
   state.alu_forward_results.clear();
-  for (uint32_t alu_id {0}; alu_id < num_alus; ++alu_id) {
+
+  for (uint32_t alu_id {0}; alu_id < params.num_alus(); ++alu_id) {
     // check if there are results to forward
     if (!state.alu_results.at(alu_id).empty()) {
-      // copy the result to the forward results
-      state.alu_forward_results.push_back(state.alu_results.at(alu_id).front());
+      forward(state, state.alu_results.at(alu_id).front());
     }
   }
+  if (!state.load_store_result.empty()) {
+    forward(state, state.load_store_result.front());
+  }
+}
+
+void forward_unit::forward(processor_state& state, const alu_result_t& result) {
+  // copy the result to the forward results
+  state.alu_forward_results.push_back(result);
+  RECORD_PIPELINE_EVENT(m_recorder, on_forward(result.pc, result.dest_register));
+
+  // results raising an exception do not provide a value
+  if (!result.exception) {
+    state.forwarded_values.at(result.dest_register) = result.result;
+  }
 }
+
+#define INSTANTIATE_FORWARD_UNIT(params_t) \
+  template void forward_unit::step(processor_state&, const params_t&);
+FOR_EACH_MACHINE_PARAMS(INSTANTIATE_FORWARD_UNIT)
@@ -3,11 +3,18 @@
 
 
 
+#include "machine_params.h"
+#include "pipeline_recorder.h"
 #include "processor_state.h"
 
 class forward_unit {
 public:
-  void step(processor_state& state);
+  template <typename params_t>
+  void step(processor_state& state, const params_t& params);
+  void set_recorder(pipeline_recorder* recorder) { m_recorder = recorder; }
+private:
+  pipeline_recorder* m_recorder {nullptr};
+  void forward(processor_state& state, const alu_result_t& result);
 };
 
 
@@ -0,0 +1,219 @@
+#include "functional_emulator.h"
+
+#include <algorithm>
+
+functional_emulator::functional_emulator(const decoded_program_t& program, const architectural_state_t& initial_state)
+  : m_state(initial_state) {
+  m_ops.reserve(program.size());
+  for (auto& instr : program) {
+    micro_op_t op {
+      .op = micro_opcode::add,
+      .dest = static_cast<uint8_t>(instr.dest),
+      .op_a = static_cast<uint8_t>(instr.op_a),
+      .op_b = static_cast<uint8_t>(instr.op_b),
+      .imm = instr.imm,
+    };
+    switch (instr.op) {
+      case opcode::add:
+        op.op = micro_opcode::add;
+        break;
+      case opcode::addi:
+        op.op = micro_opcode::add_immediate;
+        break;
+      case opcode::sub:
+        op.op = micro_opcode::sub;
+        break;
+      case opcode::mulu:
+        op.op = micro_opcode::mulu;
+        break;
+      case opcode::divu:
+        op.op = micro_opcode::divu;
+        break;
+      case opcode::remu:
+        op.op = micro_opcode::remu;
+        break;
+      case opcode::ld:
+        op.op = micro_opcode::load;
+        break;
+      case opcode::st:
+        op.op = micro_opcode::store;
+        break;
+      case opcode::beq:
+        op.op = micro_opcode::branch_equal;
+        break;
+      case opcode::bne:
+        op.op = micro_opcode::branch_not_equal;
+        break;
+      case opcode::bltu:
+        op.op = micro_opcode::branch_less;
+        break;
+      case opcode::bgeu:
+        op.op = micro_opcode::branch_greater_equal;
+        break;
+    }
+    m_ops.push_back(op);
+  }
+}
+
+uint64_t functional_emulator::run(const uint64_t max_instructions) {
+  if (m_state.has_exception) {
+    return 0;
+  }
+
+  // work on locals, so the registers and the pc can stay in host registers
+  auto& regs {m_state.registers};
+  const micro_op_t* const ops {m_ops.data()};
+  const uint64_t num_ops {m_ops.size()};
+  uint64_t pc {m_state.pc};
+  uint64_t num_retired {0};
+  while (pc < num_ops && num_retired < max_instructions) {
+    const micro_op_t& op {ops[pc]};
+    const uint64_t a {regs[op.op_a]};
+    const uint64_t b {regs[op.op_b]};
+    switch (op.op) {
+      case micro_opcode::add:
+        regs[op.dest] = a + b;
+        break;
+      case micro_opcode::add_immediate:
+        regs[op.dest] = a + op.imm;
+        break;
+      case micro_opcode::sub:
+        regs[op.dest] = a - b;
+        break;
+      case micro_opcode::mulu:
+        regs[op.dest] = a * b;
+        break;
+      case micro_opcode::divu:
+        if (b == 0) {
+          return raise_exception(static_cast<pc_t>(pc), num_retired);
+        }
+        regs[op.dest] = a / b;
+        break;
+      case micro_opcode::remu:
+        if (b == 0) {
+          return raise_exception(static_cast<pc_t>(pc), num_retired);
+        }
+        regs[op.dest] = a % b;
+        break;
+      case micro_opcode::load:
+        regs[op.dest] = m_state.memory.read(a + op.imm);
+        break;
+      case micro_opcode::store:
+        m_state.memory.write(a + op.imm, b);
+        break;
+      // a taken branch continues at pc + imm, the increment below included
+      case micro_opcode::branch_equal:
+        pc += a == b ? op.imm - 1 : 0;
+        break;
+      case micro_opcode::branch_not_equal:
+        pc += a != b ? op.imm - 1 : 0;
+        break;
+      case micro_opcode::branch_less:
+        pc += a < b ? op.imm - 1 : 0;
+        break;
+      case micro_opcode::branch_greater_equal:
+        pc += a >= b ? op.imm - 1 : 0;
+        break;
+    }
+    pc++;
+    num_retired++;
+  }
+  m_state.pc = static_cast<pc_t>(pc);
+  m_state.num_retired += num_retired;
+  return num_retired;
+}
+
+uint64_t functional_emulator::raise_exception(const pc_t pc, const uint64_t num_retired) {
+  // the faulting instruction does not retire
+  m_state.has_exception = true;
+  m_state.exception_pc = pc;
+  m_state.pc = exception_pc_addr;
+  m_state.num_retired += num_retired;
+  return num_retired;
+}
+
+architectural_state_t to_architectural_state(const processor_state& state) {
+  std::array<reg_t, logical_register_file_size> committed_map {};
+  for (reg_t i {0}; i < logical_register_file_size; ++i) {
+    committed_map[i] = state.register_map_table.at(i);
+  }
+  for (size_t i {state.active_list.size()}; i > 0; --i) {
+    const active_list_entry_t& entry {state.active_list[i - 1]};
+    committed_map[entry.logical_destination] = entry.old_destination;
+  }
+
+  architectural_state_t arch_state;
+  for (reg_t i {0}; i < logical_register_file_size; ++i) {
+    arch_state.registers[i] = state.physical_register_file.at(committed_map[i]);
+  }
+  arch_state.memory = state.memory;
+  arch_state.has_exception = state.has_exception;
+  arch_state.exception_pc = state.exception_pc;
+
+  // the next instruction to commit is the oldest one in flight
+  if (state.has_exception) {
+    arch_state.pc = exception_pc_addr;
+  } else if (!state.active_list.empty() && !state.misprediction_rollback) {
+    arch_state.pc = state.active_list.front().pc;
+  } else if (!state.decoded_pcs.empty()) {
+    arch_state.pc = state.decoded_pcs.front().first;
+  } else {
+    arch_state.pc = state.pc;
+  }
+  return arch_state;
+}
+
+processor_state to_processor_state(const architectural_state_t& arch_state, const machine_config& config) {
+  // the initial processor state already maps logical register i to physical register i
+  processor_state state(config);
+  state.pc = arch_state.pc;
+  for (reg_t i {0}; i < logical_register_file_size; ++i) {
+    state.physical_register_file[i] = arch_state.registers[i];
+  }
+  state.memory = arch_state.memory;
+  state.has_exception = arch_state.has_exception;
+  state.exception_pc = arch_state.exception_pc;
+  return state;
+}
+
+std::optional<std::string> compare_final_state(const processor_state& state, const architectural_state_t& golden) {
+  if (!state.active_list.empty() || !state.integer_queue.empty() || !state.decoded_pcs.empty()) {
+    return "the pipeline is not empty";
+  }
+  if (state.exception) {
+    return "the processor is still recovering from an exception";
+  }
+  if (state.pc != golden.pc) {
+    return "PC is " + std::to_string(state.pc) + ", expected " + std::to_string(golden.pc);
+  }
+  if (state.has_exception != golden.has_exception) {
+    return golden.has_exception ? "missing exception" : "unexpected exception";
+  }
+  if (golden.has_exception && state.exception_pc != golden.exception_pc) {
+    return "ExceptionPC is " + std::to_string(state.exception_pc) + ", expected " + std::to_string(golden.exception_pc);
+  }
+  const architectural_state_t arch_state {to_architectural_state(state)};
+  for (reg_t i {0}; i < logical_register_file_size; ++i) {
+    if (arch_state.registers[i] != golden.registers[i]) {
+      return "x" + std::to_string(i) + " is " + std::to_string(arch_state.registers[i])
+        + ", expected " + std::to_string(golden.registers[i]);
+    }
+  }
+  if (state.memory != golden.memory) {
+    // report the lowest address holding different values
+    const auto actual {state.memory.words()};
+    const auto expected {golden.memory.words()};
+    const auto [actual_it, expected_it] = std::mismatch(actual.begin(), actual.end(), expected.begin(), expected.end());
+    uint64_t address {0};
+    if (actual_it == actual.end()) {
+      address = expected_it->first;
+    } else if (expected_it == expected.end()) {
+      address = actual_it->first;
+    } else {
+      address = std::min(actual_it->first, expected_it->first);
+    }
+    return "memory word " + std::to_string(address) + " is " + std::to_string(state.memory.read(address))
+      + ", expected " + std::to_string(golden.memory.read(address));
+  }
+  return std::nullopt;
+}
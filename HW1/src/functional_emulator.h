@@ -0,0 +1,96 @@
+#ifndef FUNCTIONAL_EMULATOR_H
+#define FUNCTIONAL_EMULATOR_H
+
+
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "common.h"
+#include "data_memory.h"
+#include "machine_config.h"
+#include "processor_state.h"
+
+// architectural state of the program: what the committed instructions produced
+struct architectural_state_t {
+  pc_t pc {0};
+  std::array<uint64_t, logical_register_file_size> registers {};
+  data_memory memory;
+  bool has_exception {false};
+  pc_t exception_pc {0};
+  uint64_t num_retired {0};
+};
+
+/* Executes the program one instruction at a time, without modeling the
+ * pipeline. It is the golden model of the simulator, and fast-forwards it by
+ * producing the architectural state to seed a processor_state with.
+ *
+ * The instructions are translated once into dense micro-ops, where addi is an
+ * add whose second operand is the immediate, so the dispatch loop only
+ * switches on a small opcode. A branch writes its first register with its
+ * own value, so it only moves the pc. A division by zero stops the program like the
+ * simulator does: pc becomes exception_pc_addr, exception_pc the pc of the
+ * faulting instruction, and the destination register is not written.
+ */
+class functional_emulator {
+public:
+  explicit functional_emulator(const decoded_program_t& program, const architectural_state_t& initial_state = {});
+  // checks if there are instructions left to execute
+  bool done() const { return m_state.has_exception || m_state.pc >= m_ops.size(); }
+  // executes at most max_instructions instructions, returning the number of retired ones
+  uint64_t run(uint64_t max_instructions = UINT64_MAX);
+  const architectural_state_t& get_state() const { return m_state; }
+private:
+  enum class micro_opcode : uint8_t {
+    add,
+    add_immediate,
+    sub,
+    mulu,
+    divu,
+    remu,
+    load,
+    store,
+    branch_equal,
+    branch_not_equal,
+    branch_less,
+    branch_greater_equal,
+  };
+  struct micro_op_t {
+    micro_opcode op;
+    uint8_t dest;
+    uint8_t op_a;
+    uint8_t op_b;
+    uint64_t imm;
+  };
+  // stops the program at the faulting instruction, returning the number of instructions retired before it
+  uint64_t raise_exception(pc_t pc, uint64_t num_retired);
+  std::vector<micro_op_t> m_ops;
+  architectural_state_t m_state;
+};
+
+/* Reads the architectural state of a processor state, i.e., the state after
+ * its last committed instruction. The register map table is rolled back
+ * through the old destinations of the instructions in flight, whose registers
+ * are not freed before they commit, and the memory only holds the committed
+ * stores. While the wrong path of a mispredicted branch is rolled back, the
+ * next pc is the one the fetch was redirected to.
+ */
+architectural_state_t to_architectural_state(const processor_state& state);
+
+/* Builds the processor state of an idle pipeline holding an architectural
+ * state: logical register i is mapped to physical register i, and the other
+ * physical registers are free.
+ */
+processor_state to_processor_state(const architectural_state_t& state, const machine_config& config);
+
+/* Compares the final state of a simulation against the golden model, which
+ * ran the program to completion. Returns a description of the first
+ * mismatch, or std::nullopt if they agree.
+ */
+std::optional<std::string> compare_final_state(const processor_state& state, const architectural_state_t& golden);
+
+
+
+#endif //FUNCTIONAL_EMULATOR_H
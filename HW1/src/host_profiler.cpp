@@ -0,0 +1,93 @@
+#include "host_profiler.h"
+
+#include <iomanip>
+
+static const char* section_name(const host_section section) {
+  switch (section) {
+    case host_section::forward:
+      return "forward";
+    case host_section::commit:
+      return "commit";
+    case host_section::alu:
+      return "alu";
+    case host_section::load_store:
+      return "load/store";
+    case host_section::caches:
+      return "caches";
+    case host_section::issue:
+      return "issue";
+    case host_section::rename:
+      return "rename";
+    case host_section::decode:
+      return "decode";
+    case host_section::exception:
+      return "exception";
+    case host_section::serialize:
+      return "serialize";
+    default:
+      return "unknown";
+  }
+}
+
+host_profiler::host_profiler()
+  : m_start_ticks(now()), m_start_time(std::chrono::steady_clock::now()) {}
+
+void host_profiler::record(const host_section section, const uint64_t ticks) {
+  section_stats_t& stats {m_sections[static_cast<size_t>(section)]};
+  stats.calls++;
+  stats.ticks += ticks;
+  const uint32_t bucket {ticks == 0 ? 0u : 64u - static_cast<uint32_t>(__builtin_clzll(ticks))};
+  stats.histogram[bucket < num_buckets ? bucket : num_buckets - 1]++;
+}
+
+uint64_t host_profiler::percentile(const section_stats_t& stats, const double fraction) {
+  const double target {fraction * static_cast<double>(stats.calls)};
+  uint64_t cumulative {0};
+  for (uint32_t bucket {0}; bucket < num_buckets; ++bucket) {
+    cumulative += stats.histogram[bucket];
+    if (static_cast<double>(cumulative) >= target) {
+      return bucket == 0 ? 0 : uint64_t {1} << bucket;
+    }
+  }
+  return 0;
+}
+
+void host_profiler::print_summary(std::ostream& os, const uint64_t simulated_cycles) const {
+  // calibrate the time-stamp counter against the steady clock
+  const auto elapsed_time {std::chrono::steady_clock::now() - m_start_time};
+  const double elapsed_ns {std::chrono::duration<double, std::nano>(elapsed_time).count()};
+  const uint64_t elapsed_ticks {now() - m_start_ticks};
+  const double ns_per_tick {elapsed_ticks == 0 ? 0 : elapsed_ns / static_cast<double>(elapsed_ticks)};
+  const double cycles {static_cast<double>(simulated_cycles == 0 ? 1 : simulated_cycles)};
+
+  uint64_t total_ticks {0};
+  for (auto& stats : m_sections) {
+    total_ticks += stats.ticks;
+  }
+
+  const std::ios_base::fmtflags flags {os.flags()};
+  os << std::fixed << std::setprecision(1);
+  os << "host profile over " << simulated_cycles << " simulated cycles (p50 and p99 are bucket upper bounds)\n";
+  os << std::left << std::setw(12) << "section" << std::right << std::setw(12) << "calls" << std::setw(12) << "total ms"
+     << std::setw(10) << "share" << std::setw(14) << "ns/cycle" << std::setw(12) << "ns/call" << std::setw(10)
+     << "p50 ns" << std::setw(10) << "p99 ns" << '\n';
+  for (size_t i {0}; i < m_sections.size(); ++i) {
+    const section_stats_t& stats {m_sections[i]};
+    if (stats.calls == 0) {
+      continue;
+    }
+    const double ns {static_cast<double>(stats.ticks) * ns_per_tick};
+    os << std::left << std::setw(12) << section_name(static_cast<host_section>(i)) << std::right
+       << std::setw(12) << stats.calls
+       << std::setw(12) << ns / 1e6
+       << std::setw(9) << 100.0 * static_cast<double>(stats.ticks) / static_cast<double>(total_ticks) << '%'
+       << std::setw(14) << ns / cycles
+       << std::setw(12) << ns / static_cast<double>(stats.calls)
+       << std::setw(10) << static_cast<double>(percentile(stats, 0.5)) * ns_per_tick
+       << std::setw(10) << static_cast<double>(percentile(stats, 0.99)) * ns_per_tick << '\n';
+  }
+  const double total_ns {static_cast<double>(total_ticks) * ns_per_tick};
+  os << std::left << std::setw(12) << "total" << std::right << std::setw(12) << "" << std::setw(12) << total_ns / 1e6
+     << std::setw(10) << "100.0%" << std::setw(14) << total_ns / cycles << '\n';
+  os.flags(flags);
+}
@@ -0,0 +1,83 @@
+#ifndef HOST_PROFILER_H
+#define HOST_PROFILER_H
+
+
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// parts of the simulator whose host time is measured
+enum class host_section : uint32_t {
+  forward,
+  commit,
+  alu,
+  load_store,
+  caches,
+  issue,
+  rename,
+  decode,
+  exception,
+  serialize,
+  count,
+};
+
+/* Measures the host time spent in every pipeline unit and in serializing the
+ * states. Every measurement is a difference of the time-stamp counter, which
+ * is read in a few cycles without a system call, and goes to a histogram of
+ * the section with power-of-two buckets. The counter is converted to
+ * nanoseconds against std::chrono::steady_clock over the lifetime of the
+ * profiler, and falls back to steady_clock itself on other architectures.
+ */
+class host_profiler {
+public:
+  host_profiler();
+
+  static uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  }
+
+  void record(host_section section, uint64_t ticks);
+  // writes a table of the time per section, per call and per simulated cycle
+  void print_summary(std::ostream& os, uint64_t simulated_cycles) const;
+private:
+  static constexpr uint32_t num_buckets {64};
+  struct section_stats_t {
+    uint64_t calls {0};
+    uint64_t ticks {0};
+    // bucket i counts the calls which took less than 2^i ticks, and at least 2^(i-1)
+    std::array<uint64_t, num_buckets> histogram {};
+  };
+  // upper bound of the bucket holding the given fraction of the calls, in ticks
+  static uint64_t percentile(const section_stats_t& stats, double fraction);
+
+  std::array<section_stats_t, static_cast<size_t>(host_section::count)> m_sections {};
+  uint64_t m_start_ticks;
+  std::chrono::steady_clock::time_point m_start_time;
+};
+
+// runs a statement, measuring it if the profiler is not nullptr
+#define PROFILE_HOST_SECTION(profiler, section, statement)              \
+  do {                                                                  \
+    if ((profiler) == nullptr) {                                        \
+      statement;                                                        \
+    } else {                                                            \
+      const uint64_t profile_start {host_profiler::now()};              \
+      statement;                                                        \
+      (profiler)->record(section, host_profiler::now() - profile_start); \
+    }                                                                   \
+  } while (false)
+
+
+
+#endif //HOST_PROFILER_H
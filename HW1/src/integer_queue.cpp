@@ -0,0 +1,103 @@
+#include "integer_queue.h"
+
+#include <cassert>
+
+integer_queue_t::age_ordered_view::age_ordered_view(const integer_queue_t& queue)
+  : m_queue(&queue), m_size(queue.size()) {
+  // the rank of an entry is the number of older entries in the queue
+  for (slot_mask_t slots {queue.m_valid}; slots != 0; slots &= slots - 1) {
+    const uint32_t slot = __builtin_ctz(slots);
+    m_slots[__builtin_popcount(queue.m_older[slot] & queue.m_valid)] = static_cast<uint8_t>(slot);
+  }
+}
+
+void integer_queue_t::clear() {
+  m_valid = 0;
+  m_ready = 0;
+  m_op_a_consumers.fill(0);
+  m_op_b_consumers.fill(0);
+}
+
+uint32_t integer_queue_t::push_back(const integer_queue_entry_t& entry) {
+  assert(size() < num_slots);
+  const uint32_t slot = __builtin_ctz(~m_valid);
+  const slot_mask_t slot_bit {slot_mask_t {1} << slot};
+
+  // the new entry is younger than every entry in the queue, and the slot no longer holds an older entry
+  for (auto& older : m_older) {
+    older &= ~slot_bit;
+  }
+  m_older[slot] = m_valid;
+
+  m_entries[slot] = entry;
+  m_valid |= slot_bit;
+  update_ready(slot);
+
+  // register the entry as a consumer of the operands it waits for
+  if (!entry.op_a_is_ready) {
+    m_op_a_consumers[entry.op_a_reg_tag] |= slot_bit;
+  }
+  if (!entry.op_b_is_ready) {
+    m_op_b_consumers[entry.op_b_reg_tag] |= slot_bit;
+  }
+  return slot;
+}
+
+void integer_queue_t::erase(const uint32_t slot) {
+  const slot_mask_t slot_bit {slot_mask_t {1} << slot};
+  m_valid &= ~slot_bit;
+  m_ready &= ~slot_bit;
+}
+
+void integer_queue_t::squash(const slot_mask_t slots) {
+  m_valid &= ~slots;
+  m_ready &= ~slots;
+  for (auto& consumers : m_op_a_consumers) {
+    consumers &= ~slots;
+  }
+  for (auto& consumers : m_op_b_consumers) {
+    consumers &= ~slots;
+  }
+}
+
+void integer_queue_t::update_ready(const uint32_t slot) {
+  const slot_mask_t slot_bit {slot_mask_t {1} << slot};
+  if (m_entries[slot].op_a_is_ready && m_entries[slot].op_b_is_ready) {
+    m_ready |= slot_bit;
+  } else {
+    m_ready &= ~slot_bit;
+  }
+}
+
+uint32_t integer_queue_t::oldest(const slot_mask_t slots) const {
+  // the oldest entry is the only one with no older entry among the candidates
+  for (slot_mask_t candidates {slots}; candidates != 0; candidates &= candidates - 1) {
+    const uint32_t slot = __builtin_ctz(candidates);
+    if ((m_older[slot] & slots) == 0) {
+      return slot;
+    }
+  }
+  assert(false && "oldest called without candidates");
+  return 0;
+}
+
+void integer_queue_t::wakeup(const reg_t reg_tag, const operand_t value) {
+  for (slot_mask_t consumers {m_op_a_consumers[reg_tag]}; consumers != 0; consumers &= consumers - 1) {
+    const uint32_t slot = __builtin_ctz(consumers);
+    m_entries[slot].op_a_is_ready = true;
+    m_entries[slot].op_a_reg_tag = 0;
+    m_entries[slot].op_a_value = value;
+    update_ready(slot);
+  }
+  for (slot_mask_t consumers {m_op_b_consumers[reg_tag]}; consumers != 0; consumers &= consumers - 1) {
+    const uint32_t slot = __builtin_ctz(consumers);
+    m_entries[slot].op_b_is_ready = true;
+    m_entries[slot].op_b_reg_tag = 0;
+    m_entries[slot].op_b_value = value;
+    update_ready(slot);
+  }
+
+  // every consumer has been woken up
+  m_op_a_consumers[reg_tag] = 0;
+  m_op_b_consumers[reg_tag] = 0;
+}
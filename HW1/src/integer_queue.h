@@ -0,0 +1,88 @@
+#ifndef INTEGER_QUEUE_H
+#define INTEGER_QUEUE_H
+
+
+
+#include <array>
+#include <cstdint>
+#include "common.h"
+
+/* Integer queue stored in a fixed array of slots. Entries stay in their slot
+ * until they are erased, and the age order between them is kept as a matrix:
+ * m_older[slot] is the mask of the slots holding older entries. A mask of the
+ * entries whose operands are both ready lets the issue stage select the
+ * oldest ready entries by scanning set bits instead of walking the queue.
+ *
+ * The entries waiting for an operand are also indexed by the physical
+ * register tag they wait for, so that broadcasting a result only visits the
+ * entries consuming it.
+ */
+class integer_queue_t {
+public:
+  typedef uint32_t slot_mask_t;
+  static constexpr uint32_t num_slots {integer_queue_size_limit};
+  static_assert(num_slots <= 32, "the slot masks are 32 bits wide");
+
+  // visits the entries from the oldest to the youngest
+  class age_ordered_view {
+  public:
+    class iterator {
+    public:
+      iterator(const age_ordered_view* view, const uint32_t index)
+        : m_view(view), m_index(index) {}
+      const integer_queue_entry_t& operator*() const { return m_view->m_queue->m_entries[m_view->m_slots[m_index]]; }
+      const integer_queue_entry_t* operator->() const { return &**this; }
+      iterator& operator++() { ++m_index; return *this; }
+      bool operator==(const iterator& other) const { return m_index == other.m_index; }
+      bool operator!=(const iterator& other) const { return m_index != other.m_index; }
+    private:
+      const age_ordered_view* m_view;
+      uint32_t m_index;
+    };
+
+    explicit age_ordered_view(const integer_queue_t& queue);
+    iterator begin() const { return {this, 0}; }
+    iterator end() const { return {this, m_size}; }
+    uint32_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+  private:
+    const integer_queue_t* m_queue;
+    std::array<uint8_t, num_slots> m_slots {};
+    uint32_t m_size {0};
+  };
+
+  uint32_t size() const { return __builtin_popcount(m_valid); }
+  bool empty() const { return m_valid == 0; }
+  void clear();
+
+  // inserts an entry as the youngest one, returning its slot
+  uint32_t push_back(const integer_queue_entry_t& entry);
+  void erase(uint32_t slot);
+  // erases the entries of the given slots, which may still wait for their operands
+  void squash(slot_mask_t slots);
+  integer_queue_entry_t& operator[](const uint32_t slot) { return m_entries[slot]; }
+  const integer_queue_entry_t& operator[](const uint32_t slot) const { return m_entries[slot]; }
+
+  // masks of the occupied slots, and of those holding entries with both operands ready
+  slot_mask_t valid_mask() const { return m_valid; }
+  slot_mask_t ready_mask() const { return m_ready; }
+  // recomputes the ready bit of a slot after its operands changed
+  void update_ready(uint32_t slot);
+  // returns the slot of the oldest entry among the given non-empty mask of occupied slots
+  uint32_t oldest(slot_mask_t slots) const;
+  // provides the value of a physical register to the entries waiting for it
+  void wakeup(reg_t reg_tag, operand_t value);
+
+  age_ordered_view in_age_order() const { return age_ordered_view(*this); }
+private:
+  std::array<integer_queue_entry_t, num_slots> m_entries {};
+  std::array<slot_mask_t, num_slots> m_older {};
+  std::array<slot_mask_t, physical_register_file_size_limit> m_op_a_consumers {};
+  std::array<slot_mask_t, physical_register_file_size_limit> m_op_b_consumers {};
+  slot_mask_t m_valid {0};
+  slot_mask_t m_ready {0};
+};
+
+
+
+#endif //INTEGER_QUEUE_H
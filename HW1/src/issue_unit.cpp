@@ -1,8 +1,12 @@
 #include "issue_unit.h"
 
-#include <iostream>
+#include "logger.h"
+
+template <typename params_t>
+void issue_unit::step(processor_state& state, const params_t& params) {
+  // sample the occupancy of the integer queue every cycle
+  state.counters.integer_queue_occupancy[state.integer_queue.size()]++;
 
-void issue_unit::step(processor_state& state) {
   // check if there are instructions to issue
   if (state.integer_queue.empty()) {
     return;
@@ -16,60 +20,46 @@ void issue_unit::step(processor_state& state) {
   // forward results from ALU
   forward_from_alu_results(state);
 
-  // loop through all instructions in the integer queue and check if any is ready
-  auto it = state.integer_queue.begin();
-  while (it != state.integer_queue.end()) {
-    auto& entry = *it;
-    bool should_remove {false};
-    if (entry.op_a_is_ready && entry.op_b_is_ready) {
-      // check if there is an available ALU
-      for (auto& alu_queue : state.alu_queues) {
-        if (alu_queue.empty()) {
-          alu_queue.push({
-            .dest_register = entry.dest_register,
-            .op_a_value = entry.op_a_value,
-            .op_b_value = entry.op_b_value,
-            .op = entry.op,
-            .pc = entry.pc,
-          });
-          should_remove = true;
-          break;
-        }
-      }
-
-      // remove the instruction from the integer queue if issued
-      if (should_remove) {
-        std::cout << "issuing instruction at pc: " << entry.pc << '\n';
-        it = state.integer_queue.erase(it);
-      }
+  // find the ALUs which can accept an instruction this cycle
+  uint32_t free_alus {0};
+  for (uint32_t alu_id {0}; alu_id < params.num_alus(); ++alu_id) {
+    if (state.alu_queues[alu_id].empty()) {
+      free_alus |= 1u << alu_id;
     }
+  }
 
-    if (!should_remove) {
-      it = std::next(it);
-    }
+  // issue the oldest ready instructions, each to the free ALU with the lowest id
+  integer_queue_t::slot_mask_t ready {state.integer_queue.ready_mask()};
+  while (ready != 0 && free_alus != 0) {
+    const uint32_t slot {state.integer_queue.oldest(ready)};
+    const uint32_t alu_id = __builtin_ctz(free_alus);
+    ready &= ~(integer_queue_t::slot_mask_t {1} << slot);
+    free_alus &= free_alus - 1;
+
+    auto& entry = state.integer_queue[slot];
+    LOG_DEBUG("issuing instruction at pc: " << entry.pc << '\n');
+    state.alu_queues[alu_id].push_back({
+      .dest_register = entry.dest_register,
+      .op_a_value = entry.op_a_value,
+      .op_b_value = entry.op_b_value,
+      .op = entry.op,
+      .pc = entry.pc,
+    });
+    RECORD_PIPELINE_EVENT(m_recorder, on_issue(entry.pc, entry.dest_register, alu_id));
+    state.integer_queue.erase(slot);
+    state.counters.issued_instructions++;
   }
 }
 
 void issue_unit::forward_from_alu_results(processor_state& state) const {
-  // loop through all instructions in the active list and check if any is done
-  for (auto& entry : state.integer_queue) {
-    // check if the operand is not ready, thus requiring to check if we have forwarding results ready
-    if (!entry.op_a_is_ready) {
-      std::optional<operand_t> result_a = state.lookup_from_alu_forward_results(entry.op_a_reg_tag);
-      if (result_a.has_value()) {
-        entry.op_a_is_ready = true;
-        entry.op_a_reg_tag = 0;
-        entry.op_a_value = result_a.value();
-      }
-    }
-
-    if (!entry.op_b_is_ready) {
-      std::optional<operand_t> result_b = state.lookup_from_alu_forward_results(entry.op_b_reg_tag);
-      if (result_b.has_value()) {
-        entry.op_b_is_ready = true;
-        entry.op_b_reg_tag = 0;
-        entry.op_b_value = result_b.value();
-      }
+  // broadcast the results on the forwarding path to the instructions waiting for them
+  for (auto& alu_result : state.alu_forward_results) {
+    if (!alu_result.exception) {
+      state.integer_queue.wakeup(alu_result.dest_register, alu_result.result);
     }
   }
-}
\ No newline at end of file
+}
+
+#define INSTANTIATE_ISSUE_UNIT(params_t) \
+  template void issue_unit::step(processor_state&, const params_t&);
+FOR_EACH_MACHINE_PARAMS(INSTANTIATE_ISSUE_UNIT)
@@ -3,13 +3,18 @@
 
 
 
+#include "machine_params.h"
+#include "pipeline_recorder.h"
 #include "processor_state.h"
 
 class issue_unit {
 public:
-  void step(processor_state& state);
+  template <typename params_t>
+  void step(processor_state& state, const params_t& params);
+  void set_recorder(pipeline_recorder* recorder) { m_recorder = recorder; }
 
 private:
+  pipeline_recorder* m_recorder {nullptr};
   void forward_from_alu_results(processor_state& state) const;
 };
 
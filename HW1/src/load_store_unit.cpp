@@ -0,0 +1,175 @@
+#include "load_store_unit.h"
+
+#include <algorithm>
+#include <optional>
+#include "logger.h"
+
+void load_store_unit::step(processor_state& state, const uint32_t first_thread) {
+  // check if we are in exception mode, which squashes every uncommitted load and store
+  if (state.exception) {
+    clear(state);
+    return;
+  }
+
+  // check if there are loads or stores
+  const uint32_t num_threads {state.num_threads()};
+  bool is_empty {true};
+  for (uint32_t id {0}; id < num_threads; ++id) {
+    is_empty &= state.thread(id).load_store_queue.empty();
+  }
+  if (is_empty) {
+    return;
+  }
+  for (uint32_t id {0}; id < num_threads; ++id) {
+    forward_from_alu_results(state, state.thread(id));
+  }
+
+  // the accesses in flight get one cycle closer to their data
+  for (auto& access : state.memory_accesses) {
+    if (access.cycles_left > 0) {
+      access.cycles_left--;
+    }
+  }
+
+  // access the memory with the oldest entry which can
+  bool accessed {false};
+  bool memory_order_stall {false};
+  bool mshr_full_stall {false};
+  for (uint32_t i {0}; !accessed && i < num_threads; ++i) {
+    accessed = access(state, state.thread((first_thread + i) % num_threads), memory_order_stall, mshr_full_stall);
+  }
+  state.counters.memory_order_stall_cycles += memory_order_stall;
+  state.counters.mshr_full_stall_cycles += mshr_full_stall;
+
+  // the oldest access whose data is ready produces the result of the unit, keeping the others in order
+  bool has_result {false};
+  for (size_t i {state.memory_accesses.size()}; i > 0; --i) {
+    const alu_stage_t access {state.memory_accesses.front()};
+    state.memory_accesses.pop_front();
+    if (!has_result && access.cycles_left == 0) {
+      state.load_store_result.push_back(access.result);
+      has_result = true;
+    } else {
+      state.memory_accesses.push_back(access);
+    }
+  }
+
+  // compute the addresses of the entries whose base is ready, which access the memory from the next cycle on
+  for (uint32_t id {0}; id < num_threads; ++id) {
+    for (auto& entry : state.thread(id).load_store_queue) {
+      if (!entry.address_is_known && entry.base_is_ready) {
+        entry.address = entry.base_value + entry.offset;
+        entry.address_is_known = true;
+      }
+    }
+  }
+}
+
+bool load_store_unit::access(processor_state& state, thread_state_t& thread, bool& memory_order_stall,
+  bool& mshr_full_stall) {
+  for (size_t i {0}; i < thread.load_store_queue.size(); ++i) {
+    auto& entry = thread.load_store_queue[i];
+    if (entry.done || !entry.address_is_known) {
+      continue;
+    }
+
+    operand_t value {0};
+    uint32_t latency {1};
+    if (entry.op == opcode::st) {
+      if (!entry.data_is_ready) {
+        continue;
+      }
+      value = entry.data_value;
+      state.counters.executed_stores++;
+    } else {
+      // look for the youngest older store to the same address
+      std::optional<operand_t> forwarded;
+      bool blocked {false};
+      for (size_t j {i}; j > 0 && !blocked && !forwarded; --j) {
+        const auto& older = thread.load_store_queue[j - 1];
+        if (older.op != opcode::st) {
+          continue;
+        }
+        if (!older.address_is_known || (older.address == entry.address && !older.data_is_ready)) {
+          blocked = true;
+        } else if (older.address == entry.address) {
+          forwarded = older.data_value;
+        }
+      }
+      if (blocked) {
+        memory_order_stall = true;
+        continue;
+      }
+      if (forwarded) {
+        value = *forwarded;
+        state.counters.store_to_load_forwards++;
+      } else {
+        const auto cache_latency {state.caches.load(entry.address, state.counters)};
+        if (!cache_latency) {
+          mshr_full_stall = true;
+          continue;
+        }
+        latency = *cache_latency;
+        value = state.memory.read(entry.address);
+        state.counters.load_latency_cycles += latency;
+      }
+      state.counters.executed_loads++;
+    }
+
+    LOG_DEBUG("load/store unit executing " << entry.pc << " at address " << entry.address << " for " << latency
+      << " cycles\n");
+    RECORD_PIPELINE_EVENT(m_recorder, on_execute(entry.pc, entry.dest_register));
+    state.memory_accesses.push_back({
+      .result = {
+        .dest_register = entry.dest_register,
+        .result = value,
+        .exception = false,
+        .pc = entry.pc,
+      },
+      .cycles_left = latency - 1,
+    });
+    entry.done = true;
+    return true;
+  }
+  return false;
+}
+
+void load_store_unit::forward_from_alu_results(processor_state& state, thread_state_t& thread) const {
+  for (auto& alu_result : state.alu_forward_results) {
+    if (alu_result.exception) {
+      continue;
+    }
+    for (auto& entry : thread.load_store_queue) {
+      if (!entry.base_is_ready && entry.base_reg_tag == alu_result.dest_register) {
+        entry.base_is_ready = true;
+        entry.base_value = alu_result.result;
+      }
+      if (!entry.data_is_ready && entry.data_reg_tag == alu_result.dest_register) {
+        entry.data_is_ready = true;
+        entry.data_value = alu_result.result;
+      }
+    }
+  }
+}
+
+uint64_t load_store_unit::cycles_until_next_event(const processor_state& state) {
+  // an access whose data is ready waits at most for the next cycle
+  uint64_t cycles {0};
+  for (const auto& access : state.memory_accesses) {
+    const uint64_t access_cycles {std::max<uint64_t>(access.cycles_left, 1)};
+    cycles = cycles == 0 ? access_cycles : std::min(cycles, access_cycles);
+  }
+  return cycles;
+}
+
+void load_store_unit::skip_cycles(processor_state& state, const uint64_t cycles) {
+  for (auto& access : state.memory_accesses) {
+    access.cycles_left -= static_cast<uint32_t>(cycles);
+  }
+}
+
+void load_store_unit::clear(processor_state& state) {
+  state.load_store_queue.clear();
+  state.memory_accesses.clear();
+  state.load_store_result.clear();
+}
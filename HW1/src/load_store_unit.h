@@ -0,0 +1,46 @@
+#ifndef LOAD_STORE_UNIT_H
+#define LOAD_STORE_UNIT_H
+
+
+
+#include "pipeline_recorder.h"
+#include "processor_state.h"
+
+/* Executes the loads and stores of the load/store queue. An entry computes
+ * its address once its base register is ready, and accesses the memory from
+ * the next cycle on, the oldest ready entry first, one per cycle. A store
+ * produces the copy of its data register as its result, and writes the
+ * memory when it commits. A load reads the data of the youngest older store
+ * to the same address if there is one, and the memory otherwise; it waits
+ * while an older store has an unknown address, or matches and has no data.
+ * The caches decide when the data read from the memory is ready, and the
+ * oldest access whose data is ready produces the result of the unit.
+ *
+ * The hardware threads of a simultaneously multithreaded machine have a
+ * load/store queue each, and share the unit and the memory: the queues are
+ * visited in turn from first_thread, a load only waits for and forwards from
+ * the older stores of its own thread, and the unit still accesses the memory
+ * once per cycle.
+ */
+class load_store_unit {
+public:
+  void step(processor_state& state, uint32_t first_thread = 0);
+  void set_recorder(pipeline_recorder* recorder) { m_recorder = recorder; }
+  // number of cycles until an access in flight produces its result, or 0 if there is none
+  static uint64_t cycles_until_next_event(const processor_state& state);
+  // advances the accesses in flight through cycles in which none of them produces its result
+  static void skip_cycles(processor_state& state, uint64_t cycles);
+private:
+  pipeline_recorder* m_recorder {nullptr};
+  // provides the results on the forwarding path to the entries of a thread waiting for them
+  void forward_from_alu_results(processor_state& state, thread_state_t& thread) const;
+  /* Accesses the memory with the oldest entry of a thread which can, and
+   * returns whether one did, flagging the stalls of those which cannot.
+   */
+  bool access(processor_state& state, thread_state_t& thread, bool& memory_order_stall, bool& mshr_full_stall);
+  void clear(processor_state& state);
+};
+
+
+
+#endif //LOAD_STORE_UNIT_H
@@ -0,0 +1,52 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+
+
+#include <iostream>
+
+/* Logging with levels that can be removed at compile time. Messages above
+ * SIM_LOG_LEVEL are compiled out entirely, so the release build has no
+ * logging code on the simulation hot path. The remaining levels are filtered
+ * at runtime against the level set with set_log_level, e.g., by --verbose.
+ */
+enum class log_level : int {
+  none = 0,
+  error = 1,
+  info = 2,
+  debug = 3, // per-cycle messages of the pipeline units
+};
+
+#ifndef SIM_LOG_LEVEL
+#define SIM_LOG_LEVEL 3
+#endif
+
+namespace logger_detail {
+  inline log_level runtime_level {log_level::error};
+}
+
+inline void set_log_level(const log_level level) {
+  logger_detail::runtime_level = level;
+}
+
+inline bool log_enabled(const log_level level) {
+  return static_cast<int>(level) <= static_cast<int>(logger_detail::runtime_level);
+}
+
+// writes a stream expression, i.e., "pc: " << pc << '\n', if the level is compiled in and enabled
+#define SIM_LOG(level, stream, message)                                 \
+  do {                                                                  \
+    if constexpr (static_cast<int>(level) <= SIM_LOG_LEVEL) {           \
+      if (log_enabled(level)) {                                         \
+        stream << message;                                              \
+      }                                                                 \
+    }                                                                   \
+  } while (false)
+
+#define LOG_ERROR(message) SIM_LOG(log_level::error, std::cerr, message)
+#define LOG_INFO(message) SIM_LOG(log_level::info, std::cout, message)
+#define LOG_DEBUG(message) SIM_LOG(log_level::debug, std::cout, message)
+
+
+
+#endif //LOGGER_H
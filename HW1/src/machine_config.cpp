@@ -0,0 +1,308 @@
+#include "machine_config.h"
+
+#include <algorithm>
+#include "common.h"
+
+bool machine_config::operator==(const machine_config& other) const {
+  return num_alus == other.num_alus
+    && active_list_size == other.active_list_size
+    && integer_queue_size == other.integer_queue_size
+    && physical_register_file_size == other.physical_register_file_size
+    && max_commit_instructions == other.max_commit_instructions
+    && max_decode_instructions == other.max_decode_instructions
+    && load_store_queue_size == other.load_store_queue_size
+    && add_latency == other.add_latency
+    && mulu_latency == other.mulu_latency
+    && mulu_initiation_interval == other.mulu_initiation_interval
+    && divu_latency == other.divu_latency
+    && divu_initiation_interval == other.divu_initiation_interval
+    && map_checkpoints == other.map_checkpoints
+    && cache_line_words == other.cache_line_words
+    && l1_sets == other.l1_sets
+    && l1_ways == other.l1_ways
+    && l1_latency == other.l1_latency
+    && l2_sets == other.l2_sets
+    && l2_ways == other.l2_ways
+    && l2_latency == other.l2_latency
+    && memory_latency == other.memory_latency
+    && mshrs == other.mshrs
+    && cache_replacement_policy == other.cache_replacement_policy
+    && branch_predictor == other.branch_predictor
+    && predictor_index_bits == other.predictor_index_bits
+    && predictor_history_length == other.predictor_history_length
+    && fetch_policy == other.fetch_policy;
+}
+
+static void check_range(const char* name, const uint32_t value, const uint32_t min, const uint32_t max) {
+  if (value < min || value > max) {
+    throw config_error(std::string {name} + " must be between " + std::to_string(min) + " and "
+      + std::to_string(max) + ", got " + std::to_string(value));
+  }
+}
+
+// the line and set index bits are taken from the address, and the pseudo-LRU tree is complete
+static void check_power_of_two(const char* name, const uint32_t value) {
+  if ((value & (value - 1)) != 0) {
+    throw config_error(std::string {name} + " must be a power of two, got " + std::to_string(value));
+  }
+}
+
+const machine_config& validate_config(const machine_config& config, const uint32_t num_threads) {
+  check_range("hardware threads", num_threads, 1, smt_threads_limit);
+  check_range("num_alus", config.num_alus, 1, num_alus_limit);
+  check_range("active_list_size", config.active_list_size, 1, active_list_size_limit);
+  check_range("integer_queue_size", config.integer_queue_size, 1, integer_queue_size_limit);
+  // every logical register of every thread is mapped, and renaming needs at least one free register
+  check_range("physical_register_file_size", config.physical_register_file_size,
+    logical_register_file_size * num_threads + 1, physical_register_file_size_limit);
+  check_range("max_commit_instructions", config.max_commit_instructions, 1, active_list_size_limit);
+  check_range("max_decode_instructions", config.max_decode_instructions, 1, max_decode_instructions_limit);
+  check_range("load_store_queue_size", config.load_store_queue_size, 1, load_store_queue_size_limit);
+  check_range("add_latency", config.add_latency, 1, alu_latency_limit);
+  check_range("mulu_latency", config.mulu_latency, 1, alu_latency_limit);
+  check_range("mulu_initiation_interval", config.mulu_initiation_interval, 1, alu_latency_limit);
+  check_range("divu_latency", config.divu_latency, 1, alu_latency_limit);
+  check_range("divu_initiation_interval", config.divu_initiation_interval, 1, alu_latency_limit);
+  check_range("map_checkpoints", config.map_checkpoints, 0, map_checkpoints_limit);
+  check_range("cache_line_words", config.cache_line_words, 1, cache_line_words_limit);
+  check_range("l1_sets", config.l1_sets, 1, cache_sets_limit);
+  check_range("l1_ways", config.l1_ways, 1, cache_ways_limit);
+  check_range("l1_latency", config.l1_latency, 1, cache_latency_limit);
+  check_range("l2_sets", config.l2_sets, 1, cache_sets_limit);
+  check_range("l2_ways", config.l2_ways, 1, cache_ways_limit);
+  check_range("l2_latency", config.l2_latency, 1, cache_latency_limit);
+  check_range("memory_latency", config.memory_latency, 1, cache_latency_limit);
+  check_range("mshrs", config.mshrs, 1, mshrs_limit);
+  check_range("cache_replacement_policy", static_cast<uint32_t>(config.cache_replacement_policy), 0,
+    static_cast<uint32_t>(cache_replacement::pseudo_lru));
+  check_range("branch_predictor", static_cast<uint32_t>(config.branch_predictor), 0,
+    static_cast<uint32_t>(branch_predictor_kind::tage));
+  // TAGE splits its storage into a base table and tagged tables of an eighth of its size
+  check_range("predictor_index_bits", config.predictor_index_bits,
+    config.branch_predictor == branch_predictor_kind::tage ? 3 : 1, predictor_index_bits_limit);
+  check_range("predictor_history_length", config.predictor_history_length, 1, predictor_history_length_limit);
+  check_range("fetch_policy", static_cast<uint32_t>(config.fetch_policy), 0,
+    static_cast<uint32_t>(fetch_policy_kind::icount));
+  check_power_of_two("cache_line_words", config.cache_line_words);
+  check_power_of_two("l1_sets", config.l1_sets);
+  check_power_of_two("l2_sets", config.l2_sets);
+  if (config.cache_replacement_policy == cache_replacement::pseudo_lru) {
+    check_power_of_two("l1_ways", config.l1_ways);
+    check_power_of_two("l2_ways", config.l2_ways);
+  }
+
+  // a decoded bundle is renamed at once, so it has to fit in the empty machine, or it would stall forever
+  const uint32_t rename_capacity {std::min({
+    config.active_list_size,
+    config.integer_queue_size,
+    config.load_store_queue_size,
+    config.physical_register_file_size - logical_register_file_size * num_threads,
+  })};
+  if (config.max_decode_instructions > rename_capacity) {
+    throw config_error("max_decode_instructions must be at most " + std::to_string(rename_capacity)
+      + " for the active list, integer queue, load/store queue and free list to hold a decoded bundle, got "
+      + std::to_string(config.max_decode_instructions));
+  }
+  return config;
+}
+
+uint32_t latency(const machine_config& config, const opcode op) {
+  switch (op) {
+    case opcode::mulu:
+      return config.mulu_latency;
+    case opcode::divu:
+    case opcode::remu:
+      return config.divu_latency;
+    default:
+      return config.add_latency;
+  }
+}
+
+uint32_t initiation_interval(const machine_config& config, const opcode op) {
+  switch (op) {
+    case opcode::mulu:
+      return config.mulu_initiation_interval;
+    case opcode::divu:
+    case opcode::remu:
+      return config.divu_initiation_interval;
+    default:
+      return 1;
+  }
+}
+
+const char* to_string(const cache_replacement policy) {
+  return policy == cache_replacement::lru ? "lru" : "pseudo_lru";
+}
+
+std::optional<cache_replacement> parse_cache_replacement(const std::string& name) {
+  if (name == "lru") {
+    return cache_replacement::lru;
+  } else if (name == "pseudo_lru") {
+    return cache_replacement::pseudo_lru;
+  }
+  return std::nullopt;
+}
+
+const char* to_string(const branch_predictor_kind kind) {
+  switch (kind) {
+    case branch_predictor_kind::bimodal:
+      return "bimodal";
+    case branch_predictor_kind::gshare:
+      return "gshare";
+    default:
+      return "tage";
+  }
+}
+
+std::optional<branch_predictor_kind> parse_branch_predictor(const std::string& name) {
+  if (name == "bimodal") {
+    return branch_predictor_kind::bimodal;
+  } else if (name == "gshare") {
+    return branch_predictor_kind::gshare;
+  } else if (name == "tage") {
+    return branch_predictor_kind::tage;
+  }
+  return std::nullopt;
+}
+
+const char* to_string(const fetch_policy_kind policy) {
+  return policy == fetch_policy_kind::round_robin ? "round_robin" : "icount";
+}
+
+std::optional<fetch_policy_kind> parse_fetch_policy(const std::string& name) {
+  if (name == "round_robin") {
+    return fetch_policy_kind::round_robin;
+  } else if (name == "icount") {
+    return fetch_policy_kind::icount;
+  }
+  return std::nullopt;
+}
+
+void set_config_parameter(machine_config& config, const std::string& name, const uint32_t value) {
+  if (name == "num_alus") {
+    config.num_alus = value;
+  } else if (name == "active_list_size") {
+    config.active_list_size = value;
+  } else if (name == "integer_queue_size") {
+    config.integer_queue_size = value;
+  } else if (name == "physical_register_file_size") {
+    config.physical_register_file_size = value;
+  } else if (name == "max_commit_instructions") {
+    config.max_commit_instructions = value;
+  } else if (name == "max_decode_instructions") {
+    config.max_decode_instructions = value;
+  } else if (name == "load_store_queue_size") {
+    config.load_store_queue_size = value;
+  } else if (name == "add_latency") {
+    config.add_latency = value;
+  } else if (name == "mulu_latency") {
+    config.mulu_latency = value;
+  } else if (name == "mulu_initiation_interval") {
+    config.mulu_initiation_interval = value;
+  } else if (name == "divu_latency") {
+    config.divu_latency = value;
+  } else if (name == "divu_initiation_interval") {
+    config.divu_initiation_interval = value;
+  } else if (name == "map_checkpoints") {
+    config.map_checkpoints = value;
+  } else if (name == "cache_line_words") {
+    config.cache_line_words = value;
+  } else if (name == "l1_sets") {
+    config.l1_sets = value;
+  } else if (name == "l1_ways") {
+    config.l1_ways = value;
+  } else if (name == "l1_latency") {
+    config.l1_latency = value;
+  } else if (name == "l2_sets") {
+    config.l2_sets = value;
+  } else if (name == "l2_ways") {
+    config.l2_ways = value;
+  } else if (name == "l2_latency") {
+    config.l2_latency = value;
+  } else if (name == "memory_latency") {
+    config.memory_latency = value;
+  } else if (name == "mshrs") {
+    config.mshrs = value;
+  } else if (name == "cache_replacement_policy") {
+    config.cache_replacement_policy = static_cast<cache_replacement>(value);
+  } else if (name == "branch_predictor") {
+    config.branch_predictor = static_cast<branch_predictor_kind>(value);
+  } else if (name == "predictor_index_bits") {
+    config.predictor_index_bits = value;
+  } else if (name == "predictor_history_length") {
+    config.predictor_history_length = value;
+  } else if (name == "fetch_policy") {
+    config.fetch_policy = static_cast<fetch_policy_kind>(value);
+  } else {
+    throw config_error("unknown machine parameter " + name);
+  }
+}
+
+machine_config apply_machine_description(machine_config config, const json& description) {
+  if (!description.is_object()) {
+    throw config_error("the machine description must be a JSON object");
+  }
+  for (auto& [name, value] : description.items()) {
+    if (name == "cache_replacement_policy" && value.is_string()) {
+      const auto policy {parse_cache_replacement(value.get<std::string>())};
+      if (!policy) {
+        throw config_error("cache_replacement_policy must be lru or pseudo_lru, got " + value.get<std::string>());
+      }
+      config.cache_replacement_policy = *policy;
+      continue;
+    }
+    if (name == "branch_predictor" && value.is_string()) {
+      const auto kind {parse_branch_predictor(value.get<std::string>())};
+      if (!kind) {
+        throw config_error("branch_predictor must be bimodal, gshare or tage, got " + value.get<std::string>());
+      }
+      config.branch_predictor = *kind;
+      continue;
+    }
+    if (name == "fetch_policy" && value.is_string()) {
+      const auto policy {parse_fetch_policy(value.get<std::string>())};
+      if (!policy) {
+        throw config_error("fetch_policy must be round_robin or icount, got " + value.get<std::string>());
+      }
+      config.fetch_policy = *policy;
+      continue;
+    }
+    if (!value.is_number_unsigned()) {
+      throw config_error(name + " must be a non-negative integer");
+    }
+    set_config_parameter(config, name, value.get<uint32_t>());
+  }
+  return config;
+}
+
+json to_json(const machine_config& config) {
+  json j;
+  j["num_alus"] = config.num_alus;
+  j["active_list_size"] = config.active_list_size;
+  j["integer_queue_size"] = config.integer_queue_size;
+  j["physical_register_file_size"] = config.physical_register_file_size;
+  j["max_commit_instructions"] = config.max_commit_instructions;
+  j["max_decode_instructions"] = config.max_decode_instructions;
+  j["load_store_queue_size"] = config.load_store_queue_size;
+  j["add_latency"] = config.add_latency;
+  j["mulu_latency"] = config.mulu_latency;
+  j["mulu_initiation_interval"] = config.mulu_initiation_interval;
+  j["divu_latency"] = config.divu_latency;
+  j["divu_initiation_interval"] = config.divu_initiation_interval;
+  j["map_checkpoints"] = config.map_checkpoints;
+  j["cache_line_words"] = config.cache_line_words;
+  j["l1_sets"] = config.l1_sets;
+  j["l1_ways"] = config.l1_ways;
+  j["l1_latency"] = config.l1_latency;
+  j["l2_sets"] = config.l2_sets;
+  j["l2_ways"] = config.l2_ways;
+  j["l2_latency"] = config.l2_latency;
+  j["memory_latency"] = config.memory_latency;
+  j["mshrs"] = config.mshrs;
+  j["cache_replacement_policy"] = to_string(config.cache_replacement_policy);
+  j["branch_predictor"] = to_string(config.branch_predictor);
+  j["predictor_index_bits"] = config.predictor_index_bits;
+  j["predictor_history_length"] = config.predictor_history_length;
+  j["fetch_policy"] = to_string(config.fetch_policy);
+  return j;
+}
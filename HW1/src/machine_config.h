@@ -0,0 +1,94 @@
+#ifndef MACHINE_CONFIG_H
+#define MACHINE_CONFIG_H
+
+
+
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include "common.h"
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+// machine parameters of the simulated processor, defaulting to the 4-wide machine of the handout
+struct machine_config {
+  uint32_t num_alus {4};
+  uint32_t active_list_size {32};
+  uint32_t integer_queue_size {32};
+  uint32_t physical_register_file_size {64};
+  uint32_t max_commit_instructions {4};
+  uint32_t max_decode_instructions {4};
+  uint32_t load_store_queue_size {16};
+  // cycles an instruction executes, by opcode, and cycles before its ALU starts the next instruction
+  uint32_t add_latency {1}; // add, addi and sub, which are fully pipelined
+  uint32_t mulu_latency {1};
+  uint32_t mulu_initiation_interval {1};
+  uint32_t divu_latency {1}; // divu and remu
+  uint32_t divu_initiation_interval {1};
+  // register map table checkpoints restoring the map after an exception or a mispredicted branch in one cycle,
+  // 0 walking the active list back
+  uint32_t map_checkpoints {0};
+  // data caches in front of a fixed-latency memory, which only decide when the loads get their data
+  uint32_t cache_line_words {8}; // 64-bit words per line
+  uint32_t l1_sets {64};
+  uint32_t l1_ways {4};
+  uint32_t l1_latency {1};
+  uint32_t l2_sets {512};
+  uint32_t l2_ways {8};
+  uint32_t l2_latency {8};
+  uint32_t memory_latency {50};
+  uint32_t mshrs {4}; // L1 misses in flight at once
+  cache_replacement cache_replacement_policy {cache_replacement::lru};
+  // direction predictor of the branches, which are fetched from the predicted target
+  branch_predictor_kind branch_predictor {branch_predictor_kind::gshare};
+  uint32_t predictor_index_bits {12}; // log2 of the entries of a table
+  uint32_t predictor_history_length {16}; // global history bits, the longest of the tagged tables for TAGE
+  // thread fetching every cycle when the machine runs several programs
+  fetch_policy_kind fetch_policy {fetch_policy_kind::round_robin};
+
+  bool operator==(const machine_config& other) const;
+  bool operator!=(const machine_config& other) const { return !(*this == other); }
+};
+
+// raised when a machine description is malformed or out of the supported bounds
+class config_error : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
+/* Checks that the parameters are within the bounds of common.h for a machine
+ * running the given number of hardware threads, returning the config or
+ * throwing a config_error.
+ */
+const machine_config& validate_config(const machine_config& config, uint32_t num_threads = 1);
+
+// execution latency and initiation interval of an opcode on the given machine
+uint32_t latency(const machine_config& config, opcode op);
+uint32_t initiation_interval(const machine_config& config, opcode op);
+
+/* Overrides the parameters of config with those of a JSON machine
+ * description, i.e., {"num_alus": 2, "active_list_size": 16}. The keys are the
+ * names of the machine_config fields, and the values integers, except for the
+ * names of the cache_replacement_policy, branch_predictor and fetch_policy. The result still has to be validated
+ * once every parameter is set.
+ */
+machine_config apply_machine_description(machine_config config, const json& description);
+
+// name of a replacement policy in machine descriptions, and the policy of a name, if there is one
+const char* to_string(cache_replacement policy);
+std::optional<cache_replacement> parse_cache_replacement(const std::string& name);
+const char* to_string(branch_predictor_kind kind);
+std::optional<branch_predictor_kind> parse_branch_predictor(const std::string& name);
+const char* to_string(fetch_policy_kind policy);
+std::optional<fetch_policy_kind> parse_fetch_policy(const std::string& name);
+
+// sets a single parameter by name, throwing a config_error if it is unknown
+void set_config_parameter(machine_config& config, const std::string& name, uint32_t value);
+
+json to_json(const machine_config& config);
+
+
+
+#endif //MACHINE_CONFIG_H
@@ -0,0 +1,84 @@
+#ifndef MACHINE_PARAMS_H
+#define MACHINE_PARAMS_H
+
+
+
+#include <cstdint>
+#include "common.h"
+#include "machine_config.h"
+
+/* Machine parameters as seen by the pipeline units. The units are templates
+ * over these policies: static_machine_params bakes a common configuration in
+ * at compile time, so that its loops have constant trip counts, while
+ * dynamic_machine_params reads any validated machine_config at runtime.
+ */
+template <uint32_t num_alus_v, uint32_t active_list_size_v, uint32_t integer_queue_size_v,
+  uint32_t physical_register_file_size_v, uint32_t max_commit_instructions_v, uint32_t max_decode_instructions_v>
+struct static_machine_params {
+  static_assert(num_alus_v <= num_alus_limit);
+  static_assert(active_list_size_v <= active_list_size_limit);
+  static_assert(integer_queue_size_v <= integer_queue_size_limit);
+  static_assert(physical_register_file_size_v <= physical_register_file_size_limit);
+  static_assert(max_decode_instructions_v <= max_decode_instructions_limit);
+
+  // the sizes are baked into the type, so the configuration only provides the parameters not bounding any loop
+  explicit static_machine_params(const machine_config& config)
+    : m_load_store_queue_size(config.load_store_queue_size), m_map_checkpoints(config.map_checkpoints),
+      m_fetch_policy(config.fetch_policy) {}
+
+  static constexpr uint32_t num_alus() { return num_alus_v; }
+  static constexpr uint32_t active_list_size() { return active_list_size_v; }
+  static constexpr uint32_t integer_queue_size() { return integer_queue_size_v; }
+  static constexpr uint32_t physical_register_file_size() { return physical_register_file_size_v; }
+  static constexpr uint32_t max_commit_instructions() { return max_commit_instructions_v; }
+  static constexpr uint32_t max_decode_instructions() { return max_decode_instructions_v; }
+  uint32_t load_store_queue_size() const { return m_load_store_queue_size; }
+  uint32_t map_checkpoints() const { return m_map_checkpoints; }
+  fetch_policy_kind fetch_policy() const { return m_fetch_policy; }
+
+  // the parameters read at runtime do not take part in the selection
+  static bool matches(const machine_config& config) {
+    return config.num_alus == num_alus_v
+      && config.active_list_size == active_list_size_v
+      && config.integer_queue_size == integer_queue_size_v
+      && config.physical_register_file_size == physical_register_file_size_v
+      && config.max_commit_instructions == max_commit_instructions_v
+      && config.max_decode_instructions == max_decode_instructions_v;
+  }
+private:
+  uint32_t m_load_store_queue_size;
+  uint32_t m_map_checkpoints;
+  fetch_policy_kind m_fetch_policy;
+};
+
+// the 4-wide machine of the handout, which is the default configuration
+typedef static_machine_params<4, 32, 32, 64, 4, 4> default_machine_params;
+// an 8-wide machine with twice the active list and physical registers
+typedef static_machine_params<8, 64, 32, 128, 8, 8> wide_machine_params;
+
+class dynamic_machine_params {
+public:
+  explicit dynamic_machine_params(const machine_config& config)
+    : m_config(config) {}
+  uint32_t num_alus() const { return m_config.num_alus; }
+  uint32_t active_list_size() const { return m_config.active_list_size; }
+  uint32_t integer_queue_size() const { return m_config.integer_queue_size; }
+  uint32_t physical_register_file_size() const { return m_config.physical_register_file_size; }
+  uint32_t max_commit_instructions() const { return m_config.max_commit_instructions; }
+  uint32_t max_decode_instructions() const { return m_config.max_decode_instructions; }
+  uint32_t load_store_queue_size() const { return m_config.load_store_queue_size; }
+  uint32_t map_checkpoints() const { return m_config.map_checkpoints; }
+  fetch_policy_kind fetch_policy() const { return m_config.fetch_policy; }
+private:
+  machine_config m_config;
+};
+
+// expands X(params_t) for every policy the pipeline units are instantiated for
+#define FOR_EACH_MACHINE_PARAMS(X) \
+  X(default_machine_params)        \
+  X(wide_machine_params)           \
+  X(dynamic_machine_params)
+
+
+
+#endif //MACHINE_PARAMS_H
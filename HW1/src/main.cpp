@@ -1,69 +1,145 @@
+#include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <optional>
 #include <string>
+#include <vector>
+#include "cli_options.h"
 #include "json.hpp"
-#include "simulator.h"
+#include "logger.h"
+#include "machine_config.h"
+#include "simulation_runner.h"
 
 using json = nlohmann::json;
 
-std::optional<json> read_json(std::istream& file) {
-  json data = json::parse(file);
-  return data;
-}
+// simulates every job of the manifest in parallel, then reports the time of each and the aggregate throughput
+static int run_batch_mode(const cli_options& options, const machine_config& config, const run_options_t& run_options) {
+  std::ifstream manifest_file(options.batch_file_name);
+  if (!manifest_file.is_open()) {
+    std::cerr << "Failed to open file: " << options.batch_file_name << std::endl;
+    return 1;
+  }
+  std::vector<simulation_job_t> jobs;
+  try {
+    jobs = read_manifest(manifest_file);
+  } catch (const simulation_error& e) {
+    std::cerr << "Invalid manifest " << options.batch_file_name << ": " << e.what() << std::endl;
+    return 1;
+  }
+
+  const auto start {std::chrono::steady_clock::now()};
+  const std::vector<simulation_result_t> results {run_batch(jobs, config, run_options, options.num_jobs)};
+  const double seconds {std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
 
-void write_json(std::ostream& os, const json& data) {
-  os << data.dump(4) << std::endl;
+  uint64_t total_cycles {0};
+  uint32_t num_failed {0};
+  std::cout << std::fixed << std::setprecision(3);
+  for (size_t i {0}; i < jobs.size(); ++i) {
+    if (results[i].ok) {
+      std::cout << jobs[i].input_file_name << ": " << results[i].cycles << " cycles in "
+                << results[i].seconds * 1e3 << " ms\n";
+      total_cycles += results[i].cycles;
+    } else {
+      std::cout << jobs[i].input_file_name << ": failed: " << results[i].error << '\n';
+      num_failed++;
+    }
+  }
+  std::cout << jobs.size() << " programs (" << num_failed << " failed), " << total_cycles << " cycles in "
+            << seconds << " s, " << std::setprecision(0) << (seconds > 0 ? total_cycles / seconds : 0)
+            << " cycles/s" << std::endl;
+  return num_failed == 0 ? 0 : 1;
 }
 
-int main(int argc, char *argv[]) {
-  if (argc != 3) {
-    std::cerr << "Usage: " << argv[0] << " <input file> <output file>" << std::endl;
+// simulates the programs of the manifest as the cores of one machine, then reports the cycles of each and the throughput
+static int run_multicore_mode(const cli_options& options, const machine_config& config,
+  const run_options_t& run_options) {
+  std::ifstream manifest_file(options.multicore_file_name);
+  if (!manifest_file.is_open()) {
+    std::cerr << "Failed to open file: " << options.multicore_file_name << std::endl;
     return 1;
   }
-
-  // open input file
-  std::string input_file_name {argv[1]};
-  std::ifstream input_file(input_file_name);
-  if (!input_file.is_open()) {
-    std::cerr << "Failed to open file: " << input_file_name << std::endl;
+  std::vector<simulation_job_t> jobs;
+  std::vector<uint64_t> cycles;
+  const auto start {std::chrono::steady_clock::now()};
+  try {
+    jobs = read_manifest(manifest_file);
+    cycles = run_multicore(jobs, config, run_options, options.quantum, options.num_jobs);
+  } catch (const simulation_error& e) {
+    std::cerr << e.what() << std::endl;
     return 1;
   }
+  const double seconds {std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
 
-  // open output file
-  std::string output_file_name {argv[2]};
-  std::ofstream output_file(output_file_name);
-  if (!output_file.is_open()) {
-    std::cerr << "Failed to open file: " << output_file_name << std::endl;
-    return 1;
+  uint64_t total_cycles {0};
+  uint64_t machine_cycles {0};
+  for (size_t i {0}; i < jobs.size(); ++i) {
+    std::cout << "core " << i << " (" << jobs[i].input_file_name << "): " << cycles[i] << " cycles\n";
+    total_cycles += cycles[i];
+    machine_cycles = std::max(machine_cycles, cycles[i]);
   }
+  std::cout << std::fixed << std::setprecision(3) << jobs.size() << " cores, " << machine_cycles << " cycles in "
+            << seconds << " s, " << std::setprecision(0) << (seconds > 0 ? total_cycles / seconds : 0)
+            << " core cycles/s" << std::endl;
+  return 0;
+}
 
-  // read input file
-  std::optional<json> data = read_json(input_file);
-  if (!data) {
-    std::cerr << "Failed to read JSON data from file: " << input_file_name << std::endl;
+int main(int argc, char *argv[]) {
+  std::optional<cli_options> options = parse_cli_options(argc, argv);
+  if (!options) {
     return 1;
   }
+  set_log_level(options->verbose ? log_level::debug : log_level::error);
 
-  // create simulator
-  simulator sim(data.value());
-
-  // step through the simulator
-  json::array_t states;
-  states.push_back(sim.get_json_state());
-  uint32_t i = 0;
-  while (sim.can_step()) {
-    std::cout << "---------- cycle " << i++ << " ----------" << std::endl;
-    sim.step();
-    states.push_back(sim.get_json_state());
+  // describe the machine, starting from the default one
+  machine_config config;
+  try {
+    if (!options->config_file_name.empty()) {
+      std::ifstream config_file(options->config_file_name);
+      if (!config_file.is_open()) {
+        std::cerr << "Failed to open file: " << options->config_file_name << std::endl;
+        return 1;
+      }
+      config = apply_machine_description(config, json::parse(config_file));
+    }
+    for (auto& [name, value] : options->machine_parameters) {
+      set_config_parameter(config, name, value);
+    }
+    validate_config(config, static_cast<uint32_t>(1 + options->thread_file_names.size()));
+  } catch (const config_error& e) {
+    std::cerr << "Invalid machine configuration: " << e.what() << std::endl;
+    return 1;
+  } catch (const json::exception& e) {
+    std::cerr << "Invalid machine configuration " << options->config_file_name << ": " << e.what() << std::endl;
+    return 1;
   }
 
-  // write output file
-  write_json(output_file, states);
+  run_options_t run_options;
+  run_options.output_format = options->output_format;
+  run_options.checkpoint_interval = options->checkpoint_interval;
+  run_options.fast_forward = options->fast_forward;
+  run_options.check = options->check;
+  run_options.cosim = options->cosim;
+  run_options.stats = options->stats;
+  run_options.kanata = options->kanata;
+  run_options.profile = options->profile;
 
-  // close files
-  input_file.close();
-  output_file.close();
+  if (!options->multicore_file_name.empty()) {
+    return run_multicore_mode(*options, config, run_options);
+  }
+  if (!options->batch_file_name.empty()) {
+    return run_batch_mode(*options, config, run_options);
+  }
 
+  // simulate a single program, or several on the threads of one machine
+  try {
+    const simulation_job_t job {options->input_file_name, options->output_file_name, options->resume_file_name,
+      options->thread_file_names};
+    run_simulation(job, config, run_options);
+  } catch (const simulation_error& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
   return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,80 @@
+#include "multicore_simulator.h"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+multicore_simulator::multicore_simulator(std::vector<decoded_program_t> programs, const machine_config& config,
+  const uint64_t quantum, const uint32_t num_threads)
+  : m_quantum(quantum), m_pool(num_threads) {
+  if (quantum == 0) {
+    throw config_error("the quantum must be at least 1 cycle");
+  }
+  m_cores.reserve(programs.size());
+  for (auto& program : programs) {
+    m_cores.emplace_back(std::move(program), config);
+    m_cores.back().get_memory().enable_write_log();
+  }
+}
+
+bool multicore_simulator::can_step() const {
+  return std::any_of(m_cores.begin(), m_cores.end(), [](const simulator& sim) { return sim.can_step(); });
+}
+
+void multicore_simulator::step_quantum(const step_callback_t& on_step) {
+  // the cores share nothing until the barrier, so every one is a task of its own
+  const uint64_t quantum_end {m_quantum_start + m_quantum};
+  std::vector<std::exception_ptr> errors(m_cores.size());
+  for (size_t i {0}; i < m_cores.size(); ++i) {
+    if (!m_cores[i].can_step()) {
+      continue;
+    }
+    m_pool.submit([&, i] {
+      simulator& sim {m_cores[i]};
+      try {
+        while (sim.can_step() && sim.get_cycle() < quantum_end) {
+          if (!on_step && sim.skip_idle_cycles(quantum_end - sim.get_cycle()) != 0) {
+            continue;
+          }
+          sim.step();
+          if (on_step) {
+            on_step(i, sim);
+          }
+        }
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    });
+  }
+  m_pool.wait();
+  m_quantum_start = quantum_end;
+
+  for (const std::exception_ptr& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+  share_stores();
+}
+
+uint64_t multicore_simulator::get_cycle() const {
+  uint64_t cycle {0};
+  for (const simulator& sim : m_cores) {
+    cycle = std::max(cycle, sim.get_cycle());
+  }
+  return cycle;
+}
+
+void multicore_simulator::share_stores() {
+  std::vector<std::vector<std::pair<uint64_t, uint64_t>>> stores;
+  stores.reserve(m_cores.size());
+  for (simulator& sim : m_cores) {
+    stores.push_back(sim.get_memory().take_write_log());
+  }
+  // a core also rewrites its own stores, in case a lower core wrote the same words
+  for (simulator& sim : m_cores) {
+    for (const auto& core_stores : stores) {
+      sim.get_memory().apply(core_stores);
+    }
+  }
+}
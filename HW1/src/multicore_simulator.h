@@ -0,0 +1,65 @@
+#ifndef MULTICORE_SIMULATOR_H
+#define MULTICORE_SIMULATOR_H
+
+
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "common.h"
+#include "machine_config.h"
+#include "simulator.h"
+#include "work_stealing_pool.h"
+
+/* Cores sharing the data memory, one simulator per program, all on the same
+ * machine. Every core keeps its own processor_state and copy of the memory,
+ * and the cores are simulated in parallel on a pool of host threads for a
+ * quantum of cycles at a time, each seeing only its own stores. At the
+ * barrier ending a quantum, the stores committed by every core during the
+ * quantum are written to every memory, core by core in the order of the
+ * cores, so that the memories are equal again and the last store to a word
+ * of the highest core wins. A core thus sees the stores of the other cores
+ * up to a quantum late, and the results only depend on the quantum, not on
+ * the number of host threads or on their scheduling.
+ *
+ * The caches only model the timing of their own core, so the stores of the
+ * other cores do not invalidate their lines.
+ */
+class multicore_simulator {
+public:
+  // called on the host thread of a core after every cycle it simulates
+  typedef std::function<void(size_t core, const simulator& sim)> step_callback_t;
+
+  /* Throws a config_error if the machine parameters are out of bounds or the
+   * quantum is 0. num_threads 0 uses one host thread per hardware thread.
+   */
+  multicore_simulator(std::vector<decoded_program_t> programs, const machine_config& config, uint64_t quantum,
+    uint32_t num_threads = 0);
+  size_t num_cores() const { return m_cores.size(); }
+  simulator& core(const size_t i) { return m_cores[i]; }
+  const simulator& core(const size_t i) const { return m_cores[i]; }
+  uint64_t get_quantum() const { return m_quantum; }
+  uint32_t num_threads() const { return m_pool.num_threads(); }
+  // true while any core can step
+  bool can_step() const;
+  /* Simulates the next quantum on every core which can step, then shares the
+   * stores of the quantum. Without a callback, the idle cycles of the cores
+   * are skipped. An exception thrown by a core, or by the callback, is
+   * rethrown here once the quantum is over, that of the first core first.
+   */
+  void step_quantum(const step_callback_t& on_step = {});
+  // the cycles simulated by the slowest core since the start of the programs
+  uint64_t get_cycle() const;
+private:
+  // writes the stores committed by every core during the quantum to every memory
+  void share_stores();
+  uint64_t m_quantum;
+  // cycle at which the next quantum starts
+  uint64_t m_quantum_start {0};
+  std::vector<simulator> m_cores;
+  work_stealing_pool m_pool;
+};
+
+
+
+#endif //MULTICORE_SIMULATOR_H
@@ -0,0 +1,122 @@
+#include "perf_counters.h"
+
+#include <algorithm>
+
+perf_counters_t::perf_counters_t(const machine_config& config, const uint32_t num_threads)
+  : integer_queue_occupancy(config.integer_queue_size + 1, 0),
+    alu_busy_cycles(config.num_alus, 0),
+    commit_width_histogram(config.max_commit_instructions + 1, 0) {
+  if (num_threads > 1) {
+    thread_cycles.resize(num_threads, 0);
+    thread_committed_instructions.resize(num_threads, 0);
+    thread_fetch_cycles.resize(num_threads, 0);
+  }
+}
+
+// divides two counters, returning 0 when nothing was counted
+static double ratio(const uint64_t numerator, const uint64_t denominator) {
+  return denominator == 0 ? 0 : static_cast<double>(numerator) / static_cast<double>(denominator);
+}
+
+json perf_counters_t::to_json() const {
+  json j;
+  j["Cycles"] = cycles;
+  j["CommittedInstructions"] = committed_instructions;
+  j["IPC"] = ratio(committed_instructions, cycles);
+  j["CommitWidthHistogram"] = commit_width_histogram;
+  if (!thread_committed_instructions.empty()) {
+    json::array_t threads;
+    for (size_t i {0}; i < thread_committed_instructions.size(); ++i) {
+      threads.push_back({
+        {"Cycles", thread_cycles[i]},
+        {"CommittedInstructions", thread_committed_instructions[i]},
+        {"IPC", ratio(thread_committed_instructions[i], thread_cycles[i])},
+        {"FetchCycles", thread_fetch_cycles[i]},
+      });
+    }
+    j["Threads"] = threads;
+  }
+
+  j["Exceptions"] = exceptions;
+  j["RollbackCycles"] = rollback_cycles;
+  j["RolledBackInstructions"] = rolled_back_instructions;
+  j["MapCheckpointRecoveries"] = map_checkpoint_recoveries;
+
+  j["Branches"] = branches;
+  j["MispredictedBranches"] = mispredicted_branches;
+  j["BranchPredictionAccuracy"] = ratio(branches - mispredicted_branches, branches);
+  j["MPKI"] = ratio(mispredicted_branches * 1000, committed_instructions);
+  j["MispredictionCycles"] = misprediction_cycles;
+  j["MispredictionRollbackCycles"] = misprediction_rollback_cycles;
+
+  j["DecodedInstructions"] = decoded_instructions;
+  j["DecodeStallCycles"] = decode_stall_cycles;
+
+  j["RenamedInstructions"] = renamed_instructions;
+  j["RenameStallCycles"] = {
+    {"ActiveListFull", rename_stall_active_list_full},
+    {"IntegerQueueFull", rename_stall_integer_queue_full},
+    {"LoadStoreQueueFull", rename_stall_load_store_queue_full},
+    {"FreeListEmpty", rename_stall_free_list_empty},
+  };
+
+  j["IssuedInstructions"] = issued_instructions;
+  j["IntegerQueueOccupancyHistogram"] = integer_queue_occupancy;
+  uint64_t occupancy_sum {0};
+  uint64_t occupancy_samples {0};
+  for (size_t i {0}; i < integer_queue_occupancy.size(); ++i) {
+    occupancy_sum += i * integer_queue_occupancy[i];
+    occupancy_samples += integer_queue_occupancy[i];
+  }
+  j["AverageIntegerQueueOccupancy"] = ratio(occupancy_sum, occupancy_samples);
+
+  json::array_t alus;
+  for (const uint64_t busy_cycles : alu_busy_cycles) {
+    alus.push_back({
+      {"BusyCycles", busy_cycles},
+      {"Utilization", ratio(busy_cycles, cycles - rollback_cycles - misprediction_rollback_cycles)},
+    });
+  }
+  j["ALUs"] = alus;
+
+  j["Loads"] = executed_loads;
+  j["Stores"] = executed_stores;
+  j["StoreToLoadForwards"] = store_to_load_forwards;
+  j["MemoryOrderStallCycles"] = memory_order_stall_cycles;
+  j["AverageLoadLatency"] = ratio(load_latency_cycles, executed_loads - store_to_load_forwards);
+  j["MshrFullStallCycles"] = mshr_full_stall_cycles;
+  j["L1"] = {
+    {"Hits", l1_hits},
+    {"Misses", l1_misses},
+    {"MshrMerges", mshr_merges},
+    {"HitRate", ratio(l1_hits, l1_hits + l1_misses + mshr_merges)},
+    {"StoreHits", l1_store_hits},
+    {"StoreMisses", l1_store_misses},
+  };
+  j["L2"] = {
+    {"Hits", l2_hits},
+    {"Misses", l2_misses},
+    {"HitRate", ratio(l2_hits, l2_hits + l2_misses)},
+  };
+  return j;
+}
+
+json smt_fairness_to_json(const perf_counters_t& counters, const std::vector<double>& alone_ipcs) {
+  std::vector<double> relative_ipcs;
+  double weighted_speedup {0};
+  double inverse_sum {0};
+  for (size_t i {0}; i < alone_ipcs.size(); ++i) {
+    const double ipc {ratio(counters.thread_committed_instructions.at(i), counters.thread_cycles.at(i))};
+    relative_ipcs.push_back(alone_ipcs[i] == 0 ? 0 : ipc / alone_ipcs[i]);
+    weighted_speedup += relative_ipcs.back();
+    inverse_sum += relative_ipcs.back() == 0 ? 0 : 1 / relative_ipcs.back();
+  }
+  const auto [lowest, highest] {std::minmax_element(relative_ipcs.begin(), relative_ipcs.end())};
+  json j;
+  j["AloneIPC"] = alone_ipcs;
+  j["RelativeIPC"] = relative_ipcs;
+  j["WeightedSpeedup"] = weighted_speedup;
+  j["HarmonicMeanSpeedup"] = inverse_sum == 0 ? 0 : relative_ipcs.size() / inverse_sum;
+  j["Fairness"] = relative_ipcs.empty() || *highest == 0 ? 0 : *lowest / *highest;
+  return j;
+}
@@ -0,0 +1,93 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+
+
+#include <cstdint>
+#include <vector>
+#include "json.hpp"
+#include "machine_config.h"
+
+using json = nlohmann::json;
+
+/* Events of the simulated machine, counted by the units as they happen. A
+ * stalled stage counts one cycle per cycle it could not make progress, and
+ * the histograms are indexed by the number of instructions or entries.
+ */
+struct perf_counters_t {
+  // cycles simulated, and the ones spent rolling back the active list after an exception
+  uint64_t cycles {0};
+  uint64_t rollback_cycles {0};
+  uint64_t exceptions {0};
+  uint64_t rolled_back_instructions {0};
+  uint64_t map_checkpoint_recoveries {0}; // exceptions recovered from a map checkpoint in one cycle
+
+  // decode
+  uint64_t decoded_instructions {0};
+  uint64_t decode_stall_cycles {0}; // the decoded instructions were not renamed yet
+
+  // rename, the stalls being attributed to the first structure without room, and to the first stalled thread
+  uint64_t renamed_instructions {0};
+  uint64_t rename_stall_active_list_full {0};
+  uint64_t rename_stall_integer_queue_full {0};
+  uint64_t rename_stall_load_store_queue_full {0};
+  uint64_t rename_stall_free_list_empty {0};
+
+  // issue
+  uint64_t issued_instructions {0};
+  std::vector<uint64_t> integer_queue_occupancy; // cycles with a given number of entries
+
+  // execute
+  std::vector<uint64_t> alu_busy_cycles; // cycles each ALU executed an instruction
+
+  // load/store unit
+  uint64_t executed_loads {0};
+  uint64_t executed_stores {0};
+  uint64_t store_to_load_forwards {0}; // loads reading the data of an older store instead of the memory
+  uint64_t memory_order_stall_cycles {0}; // a load waited for the address or the data of an older store
+  uint64_t load_latency_cycles {0}; // from accessing the caches until the data is ready, summed over the loads
+  uint64_t mshr_full_stall_cycles {0}; // a load missed the L1 while every MSHR was busy
+
+  // caches, the L1 counters of the loads reading the memory apart from the ones of the committed stores, and the L2
+  // accessed by the L1 misses of both
+  uint64_t l1_hits {0};
+  uint64_t l1_misses {0}; // the misses taking an MSHR
+  uint64_t mshr_merges {0}; // the misses on a line already on its way
+  uint64_t l1_store_hits {0};
+  uint64_t l1_store_misses {0}; // the stores allocating their line without an MSHR
+  uint64_t l2_hits {0};
+  uint64_t l2_misses {0};
+
+  // branches, counted as they commit
+  uint64_t branches {0};
+  uint64_t mispredicted_branches {0};
+  uint64_t misprediction_cycles {0}; // from fetching a mispredicted branch until the wrong path is rolled back
+  uint64_t misprediction_rollback_cycles {0}; // walking the active list back after a mispredicted branch
+
+  // commit
+  uint64_t committed_instructions {0};
+  std::vector<uint64_t> commit_width_histogram; // cycles committing a given number of instructions
+
+  // hardware threads of a simultaneously multithreaded machine, empty for a single thread
+  std::vector<uint64_t> thread_cycles; // cycles until the thread had nothing left to run
+  std::vector<uint64_t> thread_committed_instructions;
+  std::vector<uint64_t> thread_fetch_cycles; // cycles in which the thread was chosen to fetch
+
+  perf_counters_t() = default;
+  explicit perf_counters_t(const machine_config& config, uint32_t num_threads = 1);
+  // the counters, and the rates derived from them
+  json to_json() const;
+};
+
+/* Fairness of a simultaneously multithreaded run, given the IPC of every
+ * thread running alone on the same machine. The relative IPC of a thread is
+ * its IPC over its IPC alone: the weighted speedup is their sum, the
+ * harmonic mean speedup balances throughput and fairness, and the fairness
+ * is the lowest relative IPC over the highest one, 1 meaning that every
+ * thread slowed down as much.
+ */
+json smt_fairness_to_json(const perf_counters_t& counters, const std::vector<double>& alone_ipcs);
+
+
+
+#endif //PERF_COUNTERS_H
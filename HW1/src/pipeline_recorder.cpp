@@ -0,0 +1,92 @@
+#include "pipeline_recorder.h"
+
+#include "decode_unit.h"
+
+pipeline_recorder::pipeline_recorder(std::ostream& os)
+  : m_os(os) {
+  m_os << "Kanata\t0004\n";
+}
+
+void pipeline_recorder::begin_cycle(const uint64_t cycle) {
+  if (!m_started) {
+    m_os << "C=\t" << cycle << '\n';
+    m_started = true;
+  } else if (cycle > m_cycle) {
+    m_os << "C\t" << cycle - m_cycle << '\n';
+  }
+  m_cycle = cycle;
+}
+
+pipeline_recorder::in_flight_t& pipeline_recorder::find(const uint64_t key, const pc_t pc) {
+  auto it {m_in_flight.find(key)};
+  if (it == m_in_flight.end()) {
+    const uint64_t id {m_next_id++};
+    m_os << "I\t" << id << '\t' << pc << "\t0\n";
+    m_os << "L\t" << id << "\t0\t" << pc << '\n';
+    it = m_in_flight.emplace(key, in_flight_t {id, nullptr}).first;
+  }
+  return it->second;
+}
+
+void pipeline_recorder::start_stage(const uint64_t key, const pc_t pc, const char* stage) {
+  in_flight_t& instr {find(key, pc)};
+  if (instr.stage != nullptr) {
+    m_os << "E\t" << instr.id << "\t0\t" << instr.stage << '\n';
+  }
+  m_os << "S\t" << instr.id << "\t0\t" << stage << '\n';
+  instr.stage = stage;
+}
+
+void pipeline_recorder::retire(const uint64_t key, const pc_t pc, const bool squashed) {
+  in_flight_t& instr {find(key, pc)};
+  if (instr.stage != nullptr) {
+    m_os << "E\t" << instr.id << "\t0\t" << instr.stage << '\n';
+  }
+  m_os << "R\t" << instr.id << '\t' << (squashed ? 0 : m_next_retire_id++) << '\t' << (squashed ? 1 : 0) << '\n';
+  m_in_flight.erase(key);
+}
+
+void pipeline_recorder::on_decode(const pc_t pc, const instruction_t& instr) {
+  const uint64_t id {find(decoded_key(pc), pc).id};
+  m_os << "L\t" << id << "\t0\t: " << decode_unit::disassemble(instr) << '\n';
+  start_stage(decoded_key(pc), pc, "Dc");
+}
+
+void pipeline_recorder::on_squash_decoded(const pc_t pc) {
+  retire(decoded_key(pc), pc, true);
+}
+
+void pipeline_recorder::on_rename(const pc_t pc, const reg_t dest_register) {
+  // the instruction is tracked by its destination from now on
+  const auto it {m_in_flight.find(decoded_key(pc))};
+  if (it != m_in_flight.end()) {
+    m_in_flight[renamed_key(dest_register)] = it->second;
+    m_in_flight.erase(it);
+  }
+  start_stage(renamed_key(dest_register), pc, "Iq");
+}
+
+void pipeline_recorder::on_issue(const pc_t pc, const reg_t dest_register, const uint32_t alu_id) {
+  start_stage(renamed_key(dest_register), pc, "Is");
+  m_os << "L\t" << find(renamed_key(dest_register), pc).id << "\t1\tALU " << alu_id << '\n';
+}
+
+void pipeline_recorder::on_execute(const pc_t pc, const reg_t dest_register) {
+  start_stage(renamed_key(dest_register), pc, "Ex");
+}
+
+void pipeline_recorder::on_forward(const pc_t pc, const reg_t dest_register) {
+  start_stage(renamed_key(dest_register), pc, "Fw");
+}
+
+void pipeline_recorder::on_complete(const pc_t pc, const reg_t dest_register) {
+  start_stage(renamed_key(dest_register), pc, "Cm");
+}
+
+void pipeline_recorder::on_commit(const pc_t pc, const reg_t dest_register) {
+  retire(renamed_key(dest_register), pc, false);
+}
+
+void pipeline_recorder::on_squash(const pc_t pc, const reg_t dest_register) {
+  retire(renamed_key(dest_register), pc, true);
+}
@@ -0,0 +1,82 @@
+#ifndef PIPELINE_RECORDER_H
+#define PIPELINE_RECORDER_H
+
+
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include "common.h"
+
+/* Records the lifecycle of every instruction as the units move it through
+ * the pipeline, and streams it as a Kanata log (version 0004) which pipeline
+ * viewers such as Konata display. An instruction goes through the stages
+ *
+ *   Dc  decoded, waiting in DecodedPCs to be renamed
+ *   Iq  renamed, waiting in the integer queue or the load/store queue
+ *   Is  issued to an ALU, waiting in its queue
+ *   Ex  executing on an ALU or accessing memory
+ *   Fw  result on the forwarding path
+ *   Cm  done, waiting in the active list to commit
+ *
+ * and leaves it either committed or squashed by an exception or a
+ * mispredicted branch. A decoded instruction is identified by its pc, which
+ * is unique within a decoded bundle, and a renamed one by its physical
+ * destination register, which is unique among the instructions in flight
+ * even when a loop fetches the same pc again. The units report events through
+ * RECORD_PIPELINE_EVENT, which costs a pointer test when no recorder is set
+ * and nothing when built with SIM_PIPELINE_EVENTS=0.
+ */
+class pipeline_recorder {
+public:
+  explicit pipeline_recorder(std::ostream& os);
+  // advances the log to the given cycle, before the units of that cycle run
+  void begin_cycle(uint64_t cycle);
+  void on_decode(pc_t pc, const instruction_t& instr);
+  void on_squash_decoded(pc_t pc);
+  void on_rename(pc_t pc, reg_t dest_register);
+  void on_issue(pc_t pc, reg_t dest_register, uint32_t alu_id);
+  void on_execute(pc_t pc, reg_t dest_register);
+  void on_forward(pc_t pc, reg_t dest_register);
+  void on_complete(pc_t pc, reg_t dest_register);
+  void on_commit(pc_t pc, reg_t dest_register);
+  void on_squash(pc_t pc, reg_t dest_register);
+private:
+  struct in_flight_t {
+    uint64_t id;
+    const char* stage;
+  };
+  // keys of the decoded instructions, by pc, and of the renamed ones, by destination register
+  static uint64_t decoded_key(const pc_t pc) { return uint64_t {1} << 32 | pc; }
+  static uint64_t renamed_key(const reg_t dest_register) { return dest_register; }
+  // returns the instruction in flight with the key, starting to track it if it was in flight before recording
+  in_flight_t& find(uint64_t key, pc_t pc);
+  void start_stage(uint64_t key, pc_t pc, const char* stage);
+  void retire(uint64_t key, pc_t pc, bool squashed);
+
+  std::ostream& m_os;
+  std::unordered_map<uint64_t, in_flight_t> m_in_flight;
+  uint64_t m_next_id {0};
+  uint64_t m_next_retire_id {0};
+  uint64_t m_cycle {0};
+  bool m_started {false};
+};
+
+#ifndef SIM_PIPELINE_EVENTS
+#define SIM_PIPELINE_EVENTS 1
+#endif
+
+// calls an event method of a pipeline recorder, i.e., on_rename(pc, dest), if recording is compiled in and enabled
+#define RECORD_PIPELINE_EVENT(recorder, event)                          \
+  do {                                                                  \
+    if constexpr (SIM_PIPELINE_EVENTS) {                                \
+      if ((recorder) != nullptr) {                                      \
+        (recorder)->event;                                              \
+      }                                                                 \
+    }                                                                   \
+  } while (false)
+
+
+
+#endif //PIPELINE_RECORDER_H
@@ -2,42 +2,60 @@
 
 #include <optional>
 
-processor_state::processor_state() {
+processor_state::processor_state(const machine_config& config, const uint32_t num_threads) {
   // physical register file
-  physical_register_file.resize(physical_register_file_size, 0);
+  physical_register_file.resize(config.physical_register_file_size, 0);
 
-  // register map table
-  register_map_table.resize(logical_register_file_size, 0);
-  for (reg_t i = 0; i < logical_register_file_size; ++i) {
-    register_map_table[i] = i;
+  // register map tables, every thread mapping its logical registers to the next physical ones
+  if (num_threads > 1) {
+    threads.resize(num_threads);
+  }
+  register_threads.resize(config.physical_register_file_size, 0);
+  for (uint32_t id {0}; id < num_threads; ++id) {
+    thread_state_t& state {thread(id)};
+    state.register_map_table.resize(logical_register_file_size, 0);
+    for (reg_t i = 0; i < logical_register_file_size; ++i) {
+      state.register_map_table[i] = id * logical_register_file_size + i;
+      register_threads[state.register_map_table[i]] = static_cast<uint8_t>(id);
+    }
   }
 
   // free list
-  for (reg_t i = 32; i < physical_register_file_size; ++i) {
+  for (reg_t i = logical_register_file_size * num_threads; i < config.physical_register_file_size; ++i) {
     free_list.push_back(i);
   }
 
   // busy bit table
-  busy_bit_table.resize(physical_register_file_size, false);
+  busy_bit_table.resize(config.physical_register_file_size, false);
 
   // alu queues
-  alu_queues.resize(num_alus);
-  alu_results.resize(num_alus);
+  alu_queues.resize(config.num_alus);
+  alu_results.resize(config.num_alus);
+  alu_pipelines.resize(config.num_alus);
+  alu_issue_delays.resize(config.num_alus, 0);
+
+  // forwarding path, carrying the results of the ALUs and of the load/store unit
+  alu_forward_results.reserve(config.num_alus + 1);
+  forwarded_values.resize(config.physical_register_file_size);
+
+  // data caches, starting empty
+  caches = cache_hierarchy(config);
+
+  // branch predictor, starting untrained
+  predictor = branch_predictor(config);
+
+  // performance counters
+  counters = perf_counters_t(config, num_threads);
 }
 
 /* Helper function to lookup the value of a register from the ALU forward results. Returns
  * std::nullopt if the register is not found or if the result is an exception.
  */
 std::optional<operand_t> processor_state::lookup_from_alu_forward_results(reg_t reg_tag) const {
-  for (auto& alu_result : alu_forward_results) {
-    if (alu_result.dest_register == reg_tag && !alu_result.exception) {
-      return alu_result.result;
-    }
-  }
-  return std::nullopt;
+  return forwarded_values.at(reg_tag);
 }
 
-std::string opcode_to_string(const opcode op) {
+const char* opcode_to_string(const opcode op) {
   switch (op) {
     case opcode::add:
       return "add";
@@ -51,27 +69,36 @@ std::string opcode_to_string(const opcode op) {
       return "divu";
     case opcode::remu:
       return "remu";
+    case opcode::ld:
+      return "ld";
+    case opcode::st:
+      return "st";
+    case opcode::beq:
+      return "beq";
+    case opcode::bne:
+      return "bne";
+    case opcode::bltu:
+      return "bltu";
+    case opcode::bgeu:
+      return "bgeu";
     default:
       return "unknown";
   }
 }
 
-json processor_state::to_json() const {
-  json j;
-  j["PC"] = pc;
-  j["PhysicalRegisterFile"] = physical_register_file;
+// the fields of a thread, which are at the top level of the state of a single thread
+static void thread_to_json(json& j, const thread_state_t& thread) {
+  j["PC"] = thread.pc;
   json::array_t decoded_pcs_json;
-  for (auto& entry : decoded_pcs) {
+  for (auto& entry : thread.decoded_pcs) {
     decoded_pcs_json.push_back(entry.first);
   }
   j["DecodedPCs"] = decoded_pcs_json;
-  j["ExceptionPC"] = exception_pc;
-  j["Exception"] = exception;
-  j["RegisterMapTable"] = register_map_table;
-  j["FreeList"] = free_list;
-  j["BusyBitTable"] = busy_bit_table;
+  j["ExceptionPC"] = thread.exception_pc;
+  j["Exception"] = thread.exception;
+  j["RegisterMapTable"] = thread.register_map_table;
   json::array_t active_list_json;
-  for (auto& entry : active_list) {
+  for (auto& entry : thread.active_list) {
     json::object_t object;
     object["Done"] = entry.done;
     object["Exception"] = entry.exception;
@@ -81,8 +108,26 @@ json processor_state::to_json() const {
     active_list_json.push_back(object);
   }
   j["ActiveList"] = active_list_json;
+}
+
+json processor_state::to_json() const {
+  json j;
+  if (threads.empty()) {
+    thread_to_json(j, *this);
+  } else {
+    json::array_t threads_json;
+    for (const thread_state_t& thread : threads) {
+      json thread_json;
+      thread_to_json(thread_json, thread);
+      threads_json.push_back(thread_json);
+    }
+    j["Threads"] = threads_json;
+  }
+  j["PhysicalRegisterFile"] = physical_register_file;
+  j["FreeList"] = json::array_t(free_list.begin(), free_list.end());
+  j["BusyBitTable"] = busy_bit_table;
   json::array_t integer_queue_json;
-  for (auto& entry : integer_queue) {
+  for (auto& entry : integer_queue.in_age_order()) {
     json::object_t object;
     object["DestRegister"] = entry.dest_register;
     object["OpAIsReady"] = entry.op_a_is_ready;
@@ -3,40 +3,81 @@
 
 
 #include <cstdint>
-#include <deque>
-#include <list>
-#include <queue>
 #include <vector>
+#include "branch_predictor.h"
+#include "cache_hierarchy.h"
 #include "common.h"
+#include "data_memory.h"
+#include "integer_queue.h"
 #include "json.hpp"
+#include "machine_config.h"
+#include "perf_counters.h"
+#include "ring_buffer.h"
 
 #include <optional>
 
 using json = nlohmann::json;
 
-class processor_state {
-public:
+/* Program counter, front end and in-order structures of a hardware thread.
+ * The single thread of a machine is the thread_state_t part of its
+ * processor_state. A simultaneously multithreaded machine keeps its threads
+ * in processor_state::threads instead, where they share the rest of the
+ * processor_state, and leaves that part empty.
+ */
+struct thread_state_t {
   pc_t pc {};
-  std::vector<uint64_t> physical_register_file;
-  std::deque<std::pair<pc_t, instruction_t>> decoded_pcs;
+  ring_buffer<std::pair<pc_t, instruction_t>, max_decode_instructions_limit> decoded_pcs;
   pc_t exception_pc {};
   bool exception {};
   std::vector<reg_t> register_map_table;
-  std::deque<reg_t> free_list;
-  std::vector<bool> busy_bit_table;
-  std::deque<active_list_entry_t> active_list;
-  std::list<integer_queue_entry_t> integer_queue;
+  ring_buffer<active_list_entry_t, active_list_size_limit> active_list;
 
   // non-visible states
   bool has_exception {}; // indicates if we have encountered an exception before
-  std::vector<std::queue<alu_queue_entry_t>> alu_queues; // similar to register 3
-  std::vector<std::queue<alu_result_t>> alu_results; // similar to register 4
+  ring_buffer<map_checkpoint_t, map_checkpoints_limit> map_checkpoints; // of the instructions in flight, oldest first
+  ring_buffer<load_store_queue_entry_t, load_store_queue_size_limit> load_store_queue;
+  ring_buffer<branch_queue_entry_t, active_list_size_limit + max_decode_instructions_limit> branches; // in flight
+  uint64_t branch_history {}; // global history of the branches fetched, including the predicted ones in flight
+  bool misprediction_rollback {}; // the active list is rolled back after a mispredicted branch
+};
+
+class processor_state : public thread_state_t {
+public:
+  std::vector<uint64_t> physical_register_file;
+  ring_buffer<reg_t, physical_register_file_size_limit> free_list;
+  std::vector<bool> busy_bit_table;
+  integer_queue_t integer_queue;
+
+  // non-visible states
+  std::vector<ring_buffer<alu_queue_entry_t, 1>> alu_queues; // similar to register 3
+  std::vector<ring_buffer<alu_result_t, 1>> alu_results; // similar to register 4
+  std::vector<ring_buffer<alu_stage_t, alu_latency_limit>> alu_pipelines; // instructions executing, oldest first
+  std::vector<uint32_t> alu_issue_delays; // cycles before each ALU can start the instruction in its queue
+  // waiting for their data, oldest first
+  ring_buffer<alu_stage_t, load_store_queue_size_limit * smt_threads_limit> memory_accesses;
+  ring_buffer<alu_result_t, 1> load_store_result; // the result of the load/store unit, like the ALU results
+  data_memory memory; // written by the stores when they commit
+  cache_hierarchy caches; // the timing of the memory accesses
+  branch_predictor predictor; // trained by the committed branches
   std::vector<alu_result_t> alu_forward_results; // represents the wires in the forwarding path
-  processor_state();
+  std::vector<std::optional<operand_t>> forwarded_values; // the same wires, indexed by destination register
+  perf_counters_t counters; // events counted by the units, which do not affect the simulation
+  std::vector<thread_state_t> threads; // of a simultaneously multithreaded machine, empty for a single thread
+  std::vector<uint8_t> register_threads; // the thread which allocated every physical register
+  /* Sizes the register files and the ALU latches for the given machine, and
+   * maps the logical registers of every thread to its own physical ones.
+   */
+  explicit processor_state(const machine_config& config = {}, uint32_t num_threads = 1);
   json to_json() const;
   std::optional<operand_t> lookup_from_alu_forward_results(reg_t reg_tag) const;
+  uint32_t num_threads() const { return threads.empty() ? 1 : static_cast<uint32_t>(threads.size()); }
+  thread_state_t& thread(const uint32_t id) { return threads.empty() ? *this : threads[id]; }
+  const thread_state_t& thread(const uint32_t id) const { return threads.empty() ? *this : threads[id]; }
 };
 
+// returns the mnemonic of an opcode as it appears in the output states
+const char* opcode_to_string(opcode op);
+
 
 
 #endif //PROCESSOR_STATE_H
@@ -1,8 +1,10 @@
 #include "rename_unit.h"
 
+#include <algorithm>
 #include <optional>
 
-void rename_unit::step(processor_state& state) {
+template <typename params_t>
+void rename_unit::step(processor_state& state, const params_t& params) {
   // check for exception first to clear state
   if (state.exception) {
     clear(state);
@@ -14,29 +16,67 @@ void rename_unit::step(processor_state& state) {
     return;
   }
 
-  // check if we have available space in the active list and integer queue
-  unsigned long num_instructions_to_rename {state.decoded_pcs.size()};
-  if (state.active_list.size() + num_instructions_to_rename > active_list_size) {
-    return;
-  }
-  if (state.integer_queue.size() + num_instructions_to_rename > integer_queue_size) {
+  // check if we have available space in the active list, the integer queue and the free list
+  const rename_stall stall {stall_reason(state, state, params)};
+  if (stall != rename_stall::none) {
+    count_stall(state.counters, stall, 1);
     return;
   }
+  rename(state, state, 0, params);
+}
 
-  // check if we have enough registers in the free list
-  if (state.free_list.size() < num_instructions_to_rename) {
-    return;
+template <typename params_t>
+void rename_unit::smt_step(processor_state& state, const uint32_t first_thread, const params_t& params) {
+  // a cycle in which threads stall counts once, for the reason of the first stalled thread
+  uint32_t num_renamed_instructions {0};
+  rename_stall first_stall {rename_stall::none};
+  for (uint32_t i {0}; i < state.num_threads(); ++i) {
+    const uint32_t id {(first_thread + i) % state.num_threads()};
+    thread_state_t& thread {state.thread(id)};
+    if (thread.exception || thread.misprediction_rollback || thread.decoded_pcs.empty()) {
+      continue;
+    }
+    const rename_stall stall {stall_reason(state, thread, params)};
+    if (stall != rename_stall::none) {
+      first_stall = first_stall == rename_stall::none ? stall : first_stall;
+      continue;
+    }
+    if (num_renamed_instructions + thread.decoded_pcs.size() > params.max_decode_instructions()) {
+      continue;
+    }
+    num_renamed_instructions += thread.decoded_pcs.size();
+    rename(state, thread, id, params);
+  }
+  if (first_stall != rename_stall::none) {
+    count_stall(state.counters, first_stall, 1);
   }
+}
+
+template <typename params_t>
+void rename_unit::rename(processor_state& state, thread_state_t& thread, const uint32_t id, const params_t& params) {
+  const size_t num_instructions_to_rename {thread.decoded_pcs.size()};
+  state.counters.renamed_instructions += num_instructions_to_rename;
 
   // rename the next instructions
   for (uint32_t i = 0; i < num_instructions_to_rename; ++i) {
     // get the next instruction to rename
-    auto [pc, instr] = state.decoded_pcs.front();
-    state.decoded_pcs.pop_front();
+    auto [pc, instr] = thread.decoded_pcs.front();
+    thread.decoded_pcs.pop_front();
+
+    // checkpoint the map before the instructions which may raise an exception, while there are free checkpoints
+    if ((instr.op == opcode::divu || instr.op == opcode::remu)
+      && thread.map_checkpoints.size() < params.map_checkpoints()) {
+      map_checkpoint_t checkpoint {};
+      checkpoint.pc = pc;
+      checkpoint.dest_register = state.free_list.front();
+      std::copy(thread.register_map_table.begin(), thread.register_map_table.end(),
+        checkpoint.register_map_table.begin());
+      thread.map_checkpoints.push_back(checkpoint);
+    }
 
     // look up the value of the first operand
     bool op_a_is_ready {false};
-    uint32_t op_a_reg_tag {state.register_map_table.at(instr.op_a)};
+    uint32_t op_a_reg_tag {thread.register_map_table.at(instr.op_a)};
     operand_t op_a_value {0};
     std::optional<operand_t> result = state.lookup_from_alu_forward_results(op_a_reg_tag);
     if (!state.busy_bit_table.at(op_a_reg_tag)) {
@@ -53,13 +93,13 @@ void rename_unit::step(processor_state& state) {
     bool op_b_is_ready {false};
     uint32_t op_b_reg_tag {0};
     operand_t op_b_value {0};
-    if (instr.op == opcode::addi) {
-      // the second operand is an immediate value
+    if (instr.op == opcode::addi || instr.op == opcode::ld) {
+      // the second operand is an immediate value, or the unused data of a load
       op_b_is_ready = true;
       op_b_value = instr.imm;
     } else {
       // look up the value of the second operand
-      op_b_reg_tag = state.register_map_table.at(instr.op_b);
+      op_b_reg_tag = thread.register_map_table.at(instr.op_b);
       result = state.lookup_from_alu_forward_results(op_b_reg_tag);
       if (!state.busy_bit_table.at(op_b_reg_tag)) {
         op_b_is_ready = true;
@@ -74,10 +114,11 @@ void rename_unit::step(processor_state& state) {
     reg_t new_dest = state.free_list.front();
     state.free_list.pop_front();
     state.busy_bit_table[new_dest] = true;
+    state.register_threads[new_dest] = static_cast<uint8_t>(id);
 
     // rename the destination register
-    reg_t old_dest = state.register_map_table[instr.dest];
-    state.register_map_table[instr.dest] = new_dest;
+    reg_t old_dest = thread.register_map_table[instr.dest];
+    thread.register_map_table[instr.dest] = new_dest;
 
     // add the instruction to the active list
     active_list_entry_t active_list_entry {
@@ -86,8 +127,50 @@ void rename_unit::step(processor_state& state) {
       .logical_destination = instr.dest,
       .old_destination = old_dest,
       .pc = pc,
+      .dest_register = new_dest,
     };
-    state.active_list.emplace_back(active_list_entry);
+    thread.active_list.push_back(active_list_entry);
+
+    // a branch gets its destination in the branch queue, and a checkpoint of the map after it, if one is free
+    if (is_branch(instr.op)) {
+      for (auto& branch : thread.branches) {
+        if (!branch.is_renamed) {
+          branch.is_renamed = true;
+          branch.dest_register = new_dest;
+          break;
+        }
+      }
+      if (thread.map_checkpoints.size() < params.map_checkpoints()) {
+        map_checkpoint_t checkpoint {};
+        checkpoint.pc = pc;
+        checkpoint.dest_register = new_dest;
+        std::copy(thread.register_map_table.begin(), thread.register_map_table.end(),
+          checkpoint.register_map_table.begin());
+        thread.map_checkpoints.push_back(checkpoint);
+      }
+    }
+
+    // add the instruction to the load/store queue, whose second operand is the data of a store
+    if (is_memory_op(instr.op)) {
+      load_store_queue_entry_t load_store_queue_entry {
+        .dest_register =    new_dest,
+        .base_is_ready =    op_a_is_ready,
+        .base_reg_tag =     op_a_is_ready ? 0 : op_a_reg_tag,
+        .base_value =       op_a_value,
+        .data_is_ready =    op_b_is_ready,
+        .data_reg_tag =     op_b_is_ready ? 0 : op_b_reg_tag,
+        .data_value =       op_b_value,
+        .offset =           instr.imm,
+        .address_is_known = false,
+        .address =          0,
+        .done =             false,
+        .op =               instr.op,
+        .pc =               pc,
+      };
+      thread.load_store_queue.push_back(load_store_queue_entry);
+      RECORD_PIPELINE_EVENT(m_recorder, on_rename(pc, new_dest));
+      continue;
+    }
 
     // add the instruction to the integer queue
     integer_queue_entry_t integer_queue_entry {
@@ -101,10 +184,60 @@ void rename_unit::step(processor_state& state) {
       .op =            instr.op,
       .pc =            pc,
     };
-    state.integer_queue.emplace_back(integer_queue_entry);
+    state.integer_queue.push_back(integer_queue_entry);
+    RECORD_PIPELINE_EVENT(m_recorder, on_rename(pc, new_dest));
+  }
+}
+
+template <typename params_t>
+rename_stall rename_unit::stall_reason(const processor_state& state, const thread_state_t& thread,
+  const params_t& params) {
+  // the active list and the load/store queue are those of the thread, and the rest is shared by the threads
+  const size_t num_instructions_to_rename {thread.decoded_pcs.size()};
+  size_t num_memory_ops {0};
+  for (const auto& entry : thread.decoded_pcs) {
+    num_memory_ops += is_memory_op(entry.second.op);
+  }
+  if (thread.active_list.size() + num_instructions_to_rename > params.active_list_size()) {
+    return rename_stall::active_list_full;
+  }
+  if (state.integer_queue.size() + num_instructions_to_rename - num_memory_ops > params.integer_queue_size()) {
+    return rename_stall::integer_queue_full;
+  }
+  if (thread.load_store_queue.size() + num_memory_ops > params.load_store_queue_size()) {
+    return rename_stall::load_store_queue_full;
+  }
+  if (state.free_list.size() < num_instructions_to_rename) {
+    return rename_stall::free_list_empty;
+  }
+  return rename_stall::none;
+}
+
+void rename_unit::count_stall(perf_counters_t& counters, const rename_stall stall, const uint64_t cycles) {
+  switch (stall) {
+    case rename_stall::active_list_full:
+      counters.rename_stall_active_list_full += cycles;
+      break;
+    case rename_stall::integer_queue_full:
+      counters.rename_stall_integer_queue_full += cycles;
+      break;
+    case rename_stall::load_store_queue_full:
+      counters.rename_stall_load_store_queue_full += cycles;
+      break;
+    case rename_stall::free_list_empty:
+      counters.rename_stall_free_list_empty += cycles;
+      break;
+    case rename_stall::none:
+      break;
   }
 }
 
 void rename_unit::clear(processor_state& state) {
   state.integer_queue.clear();
-}
\ No newline at end of file
+}
+
+#define INSTANTIATE_RENAME_UNIT(params_t) \
+  template void rename_unit::step(processor_state&, const params_t&); \
+  template void rename_unit::smt_step(processor_state&, uint32_t, const params_t&); \
+  template rename_stall rename_unit::stall_reason(const processor_state&, const thread_state_t&, const params_t&);
+FOR_EACH_MACHINE_PARAMS(INSTANTIATE_RENAME_UNIT)
@@ -3,12 +3,40 @@
 
 
 
+#include "machine_params.h"
+#include "pipeline_recorder.h"
 #include "processor_state.h"
 
+// the first structure without room for the decoded instructions, which stalls the rename stage
+enum class rename_stall {
+  none,
+  active_list_full,
+  integer_queue_full,
+  load_store_queue_full,
+  free_list_empty,
+};
+
 class rename_unit {
 public:
-  void step(processor_state& state);
+  template <typename params_t>
+  void step(processor_state& state, const params_t& params);
+  /* Renames the latches of the hardware threads of a simultaneously
+   * multithreaded machine in turn from first_thread, as long as the
+   * instructions renamed in the cycle fit in the decode width.
+   */
+  template <typename params_t>
+  void smt_step(processor_state& state, uint32_t first_thread, const params_t& params);
+  // returns why the decoded instructions of a thread cannot be renamed in this cycle, if they cannot
+  template <typename params_t>
+  static rename_stall stall_reason(const processor_state& state, const thread_state_t& thread, const params_t& params);
+  // counts the given number of cycles stalled for the reason
+  static void count_stall(perf_counters_t& counters, rename_stall stall, uint64_t cycles);
+  void set_recorder(pipeline_recorder* recorder) { m_recorder = recorder; }
 private:
+  pipeline_recorder* m_recorder {nullptr};
+  // renames the whole latch of the given thread, which allocates its physical registers
+  template <typename params_t>
+  void rename(processor_state& state, thread_state_t& thread, uint32_t id, const params_t& params);
   void clear(processor_state& state);
 };
 
@@ -0,0 +1,141 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+/* Fixed-capacity double-ended queue stored inline in a circular array. Pushing
+ * and popping at both ends and indexed access are O(1) and never allocate.
+ * Index 0 is the front of the queue. Pushing to a full buffer throws
+ * std::length_error and popping from an empty one std::out_of_range, in every
+ * build, as the callers size the buffers from the runtime machine parameters.
+ * Indexed access and front() and back() are not checked.
+ */
+template <typename T, size_t capacity_v>
+class ring_buffer {
+  static_assert(capacity_v > 0, "ring buffers must hold at least one element");
+
+  // iterates from the front to the back, for both constant and mutable buffers
+  template <bool is_const>
+  class basic_iterator {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<is_const, const T*, T*>;
+    using reference = std::conditional_t<is_const, const T&, T&>;
+    using buffer_t = std::conditional_t<is_const, const ring_buffer, ring_buffer>;
+
+    basic_iterator(buffer_t* buffer, const size_t index)
+      : m_buffer(buffer), m_index(index) {}
+    reference operator*() const { return (*m_buffer)[m_index]; }
+    pointer operator->() const { return &(*m_buffer)[m_index]; }
+    reference operator[](const difference_type offset) const { return (*m_buffer)[m_index + offset]; }
+    basic_iterator& operator++() { ++m_index; return *this; }
+    basic_iterator operator++(int) { basic_iterator it {*this}; ++m_index; return it; }
+    basic_iterator& operator--() { --m_index; return *this; }
+    basic_iterator operator--(int) { basic_iterator it {*this}; --m_index; return it; }
+    basic_iterator& operator+=(const difference_type offset) { m_index += offset; return *this; }
+    basic_iterator& operator-=(const difference_type offset) { m_index -= offset; return *this; }
+    basic_iterator operator+(const difference_type offset) const { return {m_buffer, m_index + offset}; }
+    basic_iterator operator-(const difference_type offset) const { return {m_buffer, m_index - offset}; }
+    difference_type operator-(const basic_iterator& other) const {
+      return static_cast<difference_type>(m_index) - static_cast<difference_type>(other.m_index);
+    }
+    bool operator==(const basic_iterator& other) const { return m_index == other.m_index; }
+    bool operator!=(const basic_iterator& other) const { return m_index != other.m_index; }
+    bool operator<(const basic_iterator& other) const { return m_index < other.m_index; }
+    bool operator>(const basic_iterator& other) const { return m_index > other.m_index; }
+    bool operator<=(const basic_iterator& other) const { return m_index <= other.m_index; }
+    bool operator>=(const basic_iterator& other) const { return m_index >= other.m_index; }
+  private:
+    buffer_t* m_buffer;
+    size_t m_index;
+  };
+
+public:
+  using value_type = T;
+  using iterator = basic_iterator<false>;
+  using const_iterator = basic_iterator<true>;
+
+  static constexpr size_t capacity() { return capacity_v; }
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  bool full() const { return m_size == capacity_v; }
+
+  T& operator[](const size_t index) { return m_elements[wrap(m_head + index)]; }
+  const T& operator[](const size_t index) const { return m_elements[wrap(m_head + index)]; }
+  T& front() { return (*this)[0]; }
+  const T& front() const { return (*this)[0]; }
+  T& back() { return (*this)[m_size - 1]; }
+  const T& back() const { return (*this)[m_size - 1]; }
+
+  iterator begin() { return {this, 0}; }
+  iterator end() { return {this, m_size}; }
+  const_iterator begin() const { return {this, 0}; }
+  const_iterator end() const { return {this, m_size}; }
+
+  void push_back(const T& element) {
+    if (full()) {
+      throw std::length_error("push to a full ring buffer");
+    }
+    m_elements[wrap(m_head + m_size)] = element;
+    m_size++;
+  }
+
+  void push_front(const T& element) {
+    if (full()) {
+      throw std::length_error("push to a full ring buffer");
+    }
+    m_head = wrap(m_head + capacity_v - 1);
+    m_elements[m_head] = element;
+    m_size++;
+  }
+
+  void pop_front() {
+    if (empty()) {
+      throw std::out_of_range("pop from an empty ring buffer");
+    }
+    m_head = wrap(m_head + 1);
+    m_size--;
+  }
+
+  void pop_back() {
+    if (empty()) {
+      throw std::out_of_range("pop from an empty ring buffer");
+    }
+    m_size--;
+  }
+
+  void clear() {
+    m_head = 0;
+    m_size = 0;
+  }
+
+  template <typename input_iterator_t>
+  void assign(input_iterator_t first, const input_iterator_t last) {
+    clear();
+    for (; first != last; ++first) {
+      push_back(*first);
+    }
+  }
+
+private:
+  // maps a position in [0, 2 * capacity) to a slot of the circular array
+  static size_t wrap(const size_t position) {
+    return position < capacity_v ? position : position - capacity_v;
+  }
+
+  std::array<T, capacity_v> m_elements {};
+  size_t m_head {0};
+  size_t m_size {0};
+};
+
+
+
+#endif //RING_BUFFER_H
@@ -0,0 +1,289 @@
+#include "simulation_runner.h"
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <utility>
+#include "binary_io.h"
+#include "binary_trace.h"
+#include "functional_emulator.h"
+#include "host_profiler.h"
+#include "json.hpp"
+#include "logger.h"
+#include "multicore_simulator.h"
+#include "pipeline_recorder.h"
+#include "simulator.h"
+#include "trace_writer.h"
+#include "work_stealing_pool.h"
+
+using json = nlohmann::json;
+
+// reads and decodes a whole program before simulating it
+static decoded_program_t load_program(const std::string& file_name) {
+  std::ifstream input_file(file_name);
+  if (!input_file.is_open()) {
+    throw simulation_error("Failed to open file: " + file_name);
+  }
+  try {
+    return decode_unit::decode_program(json::parse(input_file));
+  } catch (const json::exception& e) {
+    throw simulation_error("Failed to read JSON data from file: " + file_name + ": " + e.what());
+  } catch (const program_error& e) {
+    throw simulation_error("Invalid program " + file_name + ": " + e.what());
+  }
+}
+
+// loads the program of a job, either from its input file or from its checkpoint
+static simulator load_simulator(const simulation_job_t& job, const machine_config& config) {
+  if (!job.checkpoint_file_name.empty()) {
+    std::ifstream checkpoint_file(job.checkpoint_file_name, std::ios::binary);
+    if (!checkpoint_file.is_open()) {
+      throw simulation_error("Failed to open file: " + job.checkpoint_file_name);
+    }
+    try {
+      return simulator::load_checkpoint(checkpoint_file);
+    } catch (const format_error& e) {
+      throw simulation_error("Invalid checkpoint " + job.checkpoint_file_name + ": " + e.what());
+    }
+  }
+
+  if (!job.thread_file_names.empty()) {
+    std::vector<decoded_program_t> programs {load_program(job.input_file_name)};
+    for (const std::string& file_name : job.thread_file_names) {
+      programs.push_back(load_program(file_name));
+    }
+    return simulator(std::move(programs), config);
+  }
+  return simulator(load_program(job.input_file_name), config);
+}
+
+static void save_checkpoint(const simulator& sim, const std::string& file_name) {
+  std::ofstream checkpoint_file(file_name, std::ios::binary);
+  sim.save_checkpoint(checkpoint_file);
+  if (!checkpoint_file) {
+    throw simulation_error("Failed to write file: " + file_name);
+  }
+}
+
+// opens the output file and the trace writing to it, or returns nullptr if the trace is disabled
+static std::unique_ptr<trace_writer> open_trace(const std::string& file_name, const trace_format format,
+  std::ofstream& output_file) {
+  if (format == trace_format::none) {
+    return nullptr;
+  }
+  output_file.open(file_name, std::ios::binary);
+  if (!output_file.is_open()) {
+    throw simulation_error("Failed to open file: " + file_name);
+  }
+  if (format == trace_format::binary) {
+    return std::make_unique<binary_trace_writer>(output_file);
+  }
+  return std::make_unique<json_trace_writer>(output_file);
+}
+
+// opens the Kanata log next to the output file, and a recorder writing to it
+static std::unique_ptr<pipeline_recorder> open_kanata_log(const std::string& output_file_name,
+  std::ofstream& kanata_file) {
+  kanata_file.open(output_file_name + ".kanata");
+  if (!kanata_file.is_open()) {
+    throw simulation_error("Failed to open file: " + output_file_name + ".kanata");
+  }
+  return std::make_unique<pipeline_recorder>(kanata_file);
+}
+
+// writes the performance counters next to the output file
+static void write_stats(const json& stats, const std::string& output_file_name) {
+  const std::string stats_file_name {output_file_name + ".stats.json"};
+  std::ofstream stats_file(stats_file_name);
+  stats_file << stats.dump(4) << std::endl;
+  if (!stats_file) {
+    throw simulation_error("Failed to write file: " + stats_file_name);
+  }
+}
+
+// the IPC of every program running alone on a single thread of the machine, simulated without a trace
+static std::vector<double> alone_ipcs(const std::vector<decoded_program_t>& programs, const machine_config& config) {
+  std::vector<double> ipcs;
+  for (const decoded_program_t& program : programs) {
+    simulator sim {program, config};
+    while (sim.can_step()) {
+      sim.skip_idle_cycles();
+      sim.step();
+    }
+    const perf_counters_t& counters {sim.get_state().counters};
+    ipcs.push_back(counters.cycles == 0 ? 0 : static_cast<double>(counters.committed_instructions) / counters.cycles);
+  }
+  return ipcs;
+}
+
+uint64_t run_simulation(const simulation_job_t& job, const machine_config& config, const run_options_t& options) {
+  // create simulator
+  simulator sim {load_simulator(job, config)};
+  if (options.fast_forward != 0) {
+    sim.fast_forward(options.fast_forward);
+  }
+  if (options.cosim) {
+    sim.enable_cosim();
+  }
+  std::ofstream kanata_file;
+  std::unique_ptr<pipeline_recorder> recorder;
+  if (options.kanata) {
+    recorder = open_kanata_log(job.output_file_name, kanata_file);
+    sim.set_pipeline_recorder(recorder.get());
+  }
+  std::unique_ptr<host_profiler> profiler;
+  if (options.profile) {
+    profiler = std::make_unique<host_profiler>();
+    sim.set_host_profiler(profiler.get());
+  }
+
+  // open output file, unless the trace is disabled
+  std::ofstream output_file;
+  std::unique_ptr<trace_writer> trace {open_trace(job.output_file_name, options.output_format, output_file)};
+  if (trace) {
+    PROFILE_HOST_SECTION(profiler, host_section::serialize, trace->write(sim.get_state()));
+  }
+
+  // step through the simulator, streaming every state to the output file
+  const uint64_t first_cycle {sim.get_cycle()};
+  while (sim.can_step()) {
+    // without a trace, the idle cycles are skipped in one jump, stopping short of the next checkpoint
+    if (!trace) {
+      const uint64_t interval {options.checkpoint_interval};
+      sim.skip_idle_cycles(interval == 0 ? UINT64_MAX : interval - 1 - sim.get_cycle() % interval);
+    }
+    LOG_DEBUG("---------- cycle " << sim.get_cycle() << " ----------\n");
+    try {
+      sim.step();
+    } catch (const cosim_error& e) {
+      throw simulation_error("Simulation of " + job.output_file_name + " diverged in cycle "
+        + std::to_string(sim.get_cycle()) + ", " + e.what());
+    }
+    if (trace) {
+      PROFILE_HOST_SECTION(profiler, host_section::serialize, trace->write(sim.get_state()));
+    }
+    if (options.checkpoint_interval != 0 && sim.get_cycle() % options.checkpoint_interval == 0) {
+      save_checkpoint(sim, job.output_file_name + "." + std::to_string(sim.get_cycle()) + ".ckpt");
+    }
+  }
+  if (trace) {
+    trace->close();
+  }
+  if (profiler) {
+    profiler->print_summary(std::cerr, sim.get_cycle() - first_cycle);
+  }
+  if (trace && !output_file) {
+    throw simulation_error("Failed to write file: " + job.output_file_name);
+  }
+
+  if (options.stats) {
+    json stats = sim.get_state().counters.to_json();
+    if (sim.get_programs().size() > 1) {
+      stats["Fairness"] = smt_fairness_to_json(sim.get_state().counters, alone_ipcs(sim.get_programs(), config));
+    }
+    write_stats(stats, job.output_file_name);
+  }
+
+  // run the whole program on the golden model, and compare the architectural states
+  if (options.check) {
+    functional_emulator golden(sim.get_program());
+    golden.run();
+    const auto mismatch {compare_final_state(sim.get_state(), golden.get_state())};
+    if (mismatch) {
+      throw simulation_error("Mismatch with the golden model in " + job.output_file_name + ": " + *mismatch);
+    }
+  }
+  return sim.get_cycle() - first_cycle;
+}
+
+std::vector<simulation_job_t> read_manifest(std::istream& is) {
+  std::vector<simulation_job_t> jobs;
+  std::string line;
+  for (uint32_t line_number {1}; std::getline(is, line); ++line_number) {
+    std::istringstream fields {line};
+    simulation_job_t job;
+    if (!(fields >> job.input_file_name) || job.input_file_name[0] == '#') {
+      continue;
+    }
+    std::string extra;
+    if (!(fields >> job.output_file_name) || fields >> extra) {
+      throw simulation_error("line " + std::to_string(line_number)
+        + " of the manifest must hold an input file and an output file");
+    }
+    jobs.push_back(std::move(job));
+  }
+  return jobs;
+}
+
+std::vector<simulation_result_t> run_batch(const std::vector<simulation_job_t>& jobs, const machine_config& config,
+  const run_options_t& options, const uint32_t num_threads) {
+  // every job writes its own result, so the workers share nothing
+  std::vector<simulation_result_t> results(jobs.size());
+  work_stealing_pool pool {num_threads};
+  for (size_t i {0}; i < jobs.size(); ++i) {
+    pool.submit([&, i] {
+      simulation_result_t& result {results[i]};
+      const auto start {std::chrono::steady_clock::now()};
+      try {
+        result.cycles = run_simulation(jobs[i], config, options);
+        result.ok = true;
+      } catch (const std::exception& e) {
+        result.error = e.what();
+      }
+      result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    });
+  }
+  pool.wait();
+  return results;
+}
+
+std::vector<uint64_t> run_multicore(const std::vector<simulation_job_t>& jobs, const machine_config& config,
+  const run_options_t& options, const uint64_t quantum, const uint32_t num_threads) {
+  std::vector<decoded_program_t> programs;
+  programs.reserve(jobs.size());
+  for (const simulation_job_t& job : jobs) {
+    programs.push_back(load_program(job.input_file_name));
+  }
+  multicore_simulator machine {std::move(programs), config, quantum, num_threads};
+
+  // every core writes its own files, from the host thread simulating it
+  std::vector<std::ofstream> output_files(jobs.size());
+  std::vector<std::unique_ptr<trace_writer>> traces(jobs.size());
+  std::vector<std::ofstream> kanata_files(jobs.size());
+  std::vector<std::unique_ptr<pipeline_recorder>> recorders(jobs.size());
+  for (size_t i {0}; i < jobs.size(); ++i) {
+    traces[i] = open_trace(jobs[i].output_file_name, options.output_format, output_files[i]);
+    if (traces[i]) {
+      traces[i]->write(machine.core(i).get_state());
+    }
+    if (options.kanata) {
+      recorders[i] = open_kanata_log(jobs[i].output_file_name, kanata_files[i]);
+      machine.core(i).set_pipeline_recorder(recorders[i].get());
+    }
+  }
+
+  // without a trace, the cores skip their idle cycles
+  multicore_simulator::step_callback_t on_step;
+  if (options.output_format != trace_format::none) {
+    on_step = [&traces](const size_t core, const simulator& sim) { traces[core]->write(sim.get_state()); };
+  }
+  while (machine.can_step()) {
+    machine.step_quantum(on_step);
+  }
+
+  std::vector<uint64_t> cycles;
+  for (size_t i {0}; i < jobs.size(); ++i) {
+    if (traces[i]) {
+      traces[i]->close();
+      if (!output_files[i]) {
+        throw simulation_error("Failed to write file: " + jobs[i].output_file_name);
+      }
+    }
+    if (options.stats) {
+      write_stats(machine.core(i).get_state().counters.to_json(), jobs[i].output_file_name);
+    }
+    cycles.push_back(machine.core(i).get_cycle());
+  }
+  return cycles;
+}
@@ -0,0 +1,92 @@
+#ifndef SIMULATION_RUNNER_H
+#define SIMULATION_RUNNER_H
+
+
+
+#include <cstdint>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "cli_options.h"
+#include "machine_config.h"
+
+// raised when a simulation cannot read its program or write its trace
+class simulation_error : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
+struct simulation_job_t {
+  std::string input_file_name;
+  std::string output_file_name;
+  // checkpoint to resume from instead of simulating the input file from the start
+  std::string checkpoint_file_name;
+  // programs of the other hardware threads of a simultaneously multithreaded machine running the input file
+  std::vector<std::string> thread_file_names;
+};
+
+// how the jobs are simulated, on top of their machine
+struct run_options_t {
+  trace_format output_format {trace_format::json};
+  // interval between checkpoints, 0 meaning none
+  uint64_t checkpoint_interval {0};
+  // number of instructions executed on the functional emulator before simulating the pipeline
+  uint64_t fast_forward {0};
+  // compare the final state against the functional emulator
+  bool check {false};
+  // compare every committed instruction against the functional emulator
+  bool cosim {false};
+  // write the performance counters to <output file>.stats.json at the end of the run
+  bool stats {false};
+  // write the lifecycle of every instruction to the Kanata log <output file>.kanata
+  bool kanata {false};
+  // measure the host time of every unit and of the serialization, and print it to stderr at the end of the run
+  bool profile {false};
+};
+
+struct simulation_result_t {
+  bool ok {false};
+  std::string error;
+  uint64_t cycles {0};
+  double seconds {0};
+};
+
+/* Simulates the program of the input file to completion on the given machine
+ * and writes the trace to the output file. Returns the number of simulated
+ * cycles, or throws a simulation_error. A job resuming from a checkpoint runs
+ * on the machine of the checkpoint, and its trace starts at the restored
+ * state. With a non-zero checkpoint_interval, a checkpoint is written to
+ * <output file>.<cycle>.ckpt every checkpoint_interval cycles. A mismatch
+ * with the golden model is also reported as a simulation_error.
+ *
+ * A job with thread files runs them next to the input file on the hardware
+ * threads of a simultaneously multithreaded machine. Its statistics then
+ * compare the IPC of every thread with the IPC of its program running alone
+ * on the same machine.
+ */
+uint64_t run_simulation(const simulation_job_t& job, const machine_config& config, const run_options_t& options);
+
+/* Reads a batch manifest, with one input file and one output file per line
+ * separated by whitespace. Blank lines and lines starting with '#' are
+ * skipped. Throws a simulation_error if a line is malformed.
+ */
+std::vector<simulation_job_t> read_manifest(std::istream& is);
+
+/* Simulates the programs of the jobs as the cores of a multicore_simulator,
+ * in parallel on num_threads host threads with the given quantum, and
+ * writes the trace, statistics and Kanata log of every core next to its
+ * output file. Checkpoints, fast-forwarding, the functional emulator checks
+ * and the profiler are ignored. Returns the number of cycles simulated by
+ * every core, or throws a simulation_error.
+ */
+std::vector<uint64_t> run_multicore(const std::vector<simulation_job_t>& jobs, const machine_config& config,
+  const run_options_t& options, uint64_t quantum, uint32_t num_threads);
+
+// runs the jobs on a work-stealing pool of num_threads threads, returning the results in the order of the jobs
+std::vector<simulation_result_t> run_batch(const std::vector<simulation_job_t>& jobs, const machine_config& config,
+  const run_options_t& options, uint32_t num_threads);
+
+
+
+#endif //SIMULATION_RUNNER_H
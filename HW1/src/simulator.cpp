@@ -1,29 +1,75 @@
 #include "simulator.h"
-#include <iostream>
+#include <algorithm>
+#include <utility>
+#include "checkpoint.h"
+#include "functional_emulator.h"
+#include "logger.h"
 
-simulator::simulator(const program_t &program)
-  : m_program(program) {
-  for (int i = 0; i < num_alus; ++i) {
+simulator::simulator(const program_t &program, const machine_config& config)
+  : simulator(decode_unit::decode_program(program), config) {}
+
+simulator::simulator(decoded_program_t program, const machine_config& config)
+  : simulator(std::vector<decoded_program_t> {std::move(program)}, config) {}
+
+simulator::simulator(std::vector<decoded_program_t> programs, const machine_config& config)
+  : m_programs(std::move(programs)),
+    m_config(validate_config(config, static_cast<uint32_t>(m_programs.size()))),
+    m_processor_state(config, static_cast<uint32_t>(m_programs.size())) {
+  // use the units compiled for the configuration if there are any, and the runtime parameters otherwise
+  if (default_machine_params::matches(config)) {
+    m_normal_step = &simulator::normal_step<default_machine_params>;
+    m_exception_step = &simulator::exception_step<default_machine_params>;
+  } else if (wide_machine_params::matches(config)) {
+    m_normal_step = &simulator::normal_step<wide_machine_params>;
+    m_exception_step = &simulator::exception_step<wide_machine_params>;
+  } else {
+    m_normal_step = &simulator::normal_step<dynamic_machine_params>;
+    m_exception_step = &simulator::exception_step<dynamic_machine_params>;
+  }
+
+  // a simultaneously multithreaded machine rolls its threads back within its normal step
+  if (m_programs.size() > 1) {
+    if (default_machine_params::matches(config)) {
+      m_normal_step = &simulator::smt_step<default_machine_params>;
+    } else if (wide_machine_params::matches(config)) {
+      m_normal_step = &simulator::smt_step<wide_machine_params>;
+    } else {
+      m_normal_step = &simulator::smt_step<dynamic_machine_params>;
+    }
+  }
+
+  for (uint32_t i = 0; i < config.num_alus; ++i) {
     m_alu_units.push_back(
-      alu_unit(i)
+      alu_unit(i, config)
     );
   }
 }
 
 bool simulator::can_step() const {
+  for (uint32_t id {0}; id < m_processor_state.num_threads(); ++id) {
+    if (can_step_thread(id)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool simulator::can_step_thread(const uint32_t id) const {
+  const thread_state_t& thread {m_processor_state.thread(id)};
+
   // exception states
-  if (m_processor_state.exception) {
+  if (thread.exception) {
     return true;
   }
 
   // not in exception state, but has exception before
-  if (m_processor_state.has_exception) {
+  if (thread.has_exception) {
     return false;
   }
 
-  return !m_processor_state.decoded_pcs.empty()
-    || !m_processor_state.active_list.empty()
-    || m_processor_state.pc < m_program.size();
+  return !thread.decoded_pcs.empty()
+    || !thread.active_list.empty()
+    || thread.pc < m_programs[id].size();
 }
 
 void simulator::step() {
@@ -31,33 +77,231 @@ void simulator::step() {
   if (!can_step()) {
     return;
   }
+  RECORD_PIPELINE_EVENT(m_recorder, begin_cycle(m_cycle));
 
-  // check if we have an exception
-  if (m_processor_state.exception) {
-    std::cout << "stepping exception...\n";
-    exception_step();
+  // check if we have an exception, or the wrong path of a mispredicted branch to roll back
+  if (m_processor_state.exception || m_processor_state.misprediction_rollback) {
+    LOG_DEBUG("stepping exception...\n");
+    (this->*m_exception_step)();
   } else {
-    std::cout << "stepping normal...\n";
-    normal_step();
+    LOG_DEBUG("stepping normal...\n");
+    (this->*m_normal_step)();
+  }
+  m_processor_state.counters.cycles++;
+  m_cycle++;
+}
+
+uint64_t simulator::idle_cycles() const {
+  const processor_state& state {m_processor_state};
+  const dynamic_machine_params params {m_config};
+  if (!can_step() || state.exception || state.misprediction_rollback || !state.threads.empty()) {
+    return 0;
+  }
+
+  // results on the forwarding path complete their instructions, and results in the ALUs move to the path
+  if (!state.alu_forward_results.empty()) {
+    return 0;
+  }
+  for (const auto& alu_result : state.alu_results) {
+    if (!alu_result.empty()) {
+      return 0;
+    }
+  }
+  if (!state.load_store_result.empty()) {
+    return 0;
+  }
+
+  // loads and stores are not skipped over until they accessed the memory
+  for (const auto& entry : state.load_store_queue) {
+    if (!entry.done) {
+      return 0;
+    }
+  }
+
+  // the oldest instruction commits once it is done
+  if (!state.active_list.empty() && state.active_list.front().done) {
+    return 0;
+  }
+
+  // ready instructions are issued as long as an ALU is free
+  bool has_free_alu {false};
+  for (const auto& alu_queue : state.alu_queues) {
+    has_free_alu |= alu_queue.empty();
+  }
+  if (has_free_alu && state.integer_queue.ready_mask() != 0) {
+    return 0;
+  }
+
+  // the rename stage is blocked while a structure is full, and the decode stage while the rename stage is
+  if (!state.decoded_pcs.empty() && rename_unit::stall_reason(state, state, params) == rename_stall::none) {
+    return 0;
+  }
+  if (state.decoded_pcs.empty() && state.pc < get_program().size()) {
+    return 0;
+  }
+
+  /* The pipeline stays frozen until the first ALU starts or completes an
+   * instruction, a memory access gets its data or a line arrives in the L1.
+   */
+  uint64_t next_event {0};
+  const auto add_event = [&next_event](const uint64_t cycles) {
+    if (cycles != 0 && (next_event == 0 || cycles < next_event)) {
+      next_event = cycles;
+    }
+  };
+  for (const auto& alu_unit : m_alu_units) {
+    add_event(alu_unit.cycles_until_next_event(state));
+  }
+  add_event(load_store_unit::cycles_until_next_event(state));
+  add_event(state.caches.cycles_until_next_event());
+  return next_event == 0 ? 0 : next_event - 1;
+}
+
+uint64_t simulator::skip_idle_cycles(const uint64_t max_cycles) {
+  const uint64_t num_cycles {std::min(idle_cycles(), max_cycles)};
+  if (num_cycles == 0) {
+    return 0;
   }
+
+  // count what the stalled units would have counted in every cycle
+  processor_state& state {m_processor_state};
+  const dynamic_machine_params params {m_config};
+  perf_counters_t& counters {state.counters};
+  if (!state.decoded_pcs.empty()) {
+    rename_unit::count_stall(counters, rename_unit::stall_reason(state, state, params), num_cycles);
+    if (state.pc < get_program().size()) {
+      counters.decode_stall_cycles += num_cycles;
+    }
+  }
+  counters.integer_queue_occupancy[state.integer_queue.size()] += num_cycles;
+  counters.commit_width_histogram[0] += num_cycles;
+  for (const auto& alu_unit : m_alu_units) {
+    alu_unit.skip_cycles(state, num_cycles);
+  }
+  load_store_unit::skip_cycles(state, num_cycles);
+  state.caches.skip_cycles(num_cycles);
+  counters.cycles += num_cycles;
+  m_cycle += num_cycles;
+  LOG_DEBUG("skipped " << num_cycles << " idle cycles\n");
+  return num_cycles;
 }
 
+template <typename params_t>
 void simulator::normal_step() {
+  const params_t params {m_config};
+
   // process forwarding
-  m_forward_unit.step(m_processor_state);
-  m_commit_unit.step(m_processor_state);
+  PROFILE_HOST_SECTION(m_profiler, host_section::forward, m_forward_unit.step(m_processor_state, params));
+  PROFILE_HOST_SECTION(m_profiler, host_section::commit, m_commit_unit.step(m_processor_state, params));
   for (auto& alu_unit : m_alu_units) {
-    alu_unit.step(m_processor_state);
+    PROFILE_HOST_SECTION(m_profiler, host_section::alu, alu_unit.step(m_processor_state));
   }
-  m_issue_unit.step(m_processor_state);
-  m_rename_unit.step(m_processor_state);
-  m_decode_unit.step(m_processor_state, m_program);
+  PROFILE_HOST_SECTION(m_profiler, host_section::caches, m_processor_state.caches.step());
+  PROFILE_HOST_SECTION(m_profiler, host_section::load_store, m_load_store_unit.step(m_processor_state));
+  PROFILE_HOST_SECTION(m_profiler, host_section::issue, m_issue_unit.step(m_processor_state, params));
+  PROFILE_HOST_SECTION(m_profiler, host_section::rename, m_rename_unit.step(m_processor_state, params));
+  PROFILE_HOST_SECTION(m_profiler, host_section::decode,
+    m_decode_unit.step(m_processor_state, get_program(), params));
 }
 
+template <typename params_t>
+void simulator::smt_step() {
+  const params_t params {m_config};
+  for (uint32_t id {0}; id < m_processor_state.num_threads(); ++id) {
+    m_processor_state.counters.thread_cycles[id] += can_step_thread(id);
+  }
+
+  // the threads take turns at being first to use the shared bandwidth of every stage
+  const uint32_t first_thread {static_cast<uint32_t>(m_cycle % m_processor_state.num_threads())};
+  PROFILE_HOST_SECTION(m_profiler, host_section::forward, m_forward_unit.step(m_processor_state, params));
+  PROFILE_HOST_SECTION(m_profiler, host_section::commit,
+    m_commit_unit.smt_step(m_processor_state, first_thread, params));
+  for (auto& alu_unit : m_alu_units) {
+    PROFILE_HOST_SECTION(m_profiler, host_section::alu, alu_unit.step(m_processor_state));
+  }
+  PROFILE_HOST_SECTION(m_profiler, host_section::caches, m_processor_state.caches.step());
+  PROFILE_HOST_SECTION(m_profiler, host_section::load_store,
+    m_load_store_unit.step(m_processor_state, first_thread));
+  PROFILE_HOST_SECTION(m_profiler, host_section::issue, m_issue_unit.step(m_processor_state, params));
+  PROFILE_HOST_SECTION(m_profiler, host_section::rename,
+    m_rename_unit.smt_step(m_processor_state, first_thread, params));
+  PROFILE_HOST_SECTION(m_profiler, host_section::decode,
+    m_decode_unit.smt_step(m_processor_state, m_programs, first_thread, params));
+}
+
+template <typename params_t>
 void simulator::exception_step() {
-  m_commit_unit.exception_step(m_processor_state);
+  const params_t params {m_config};
+  PROFILE_HOST_SECTION(m_profiler, host_section::exception, m_commit_unit.exception_step(m_processor_state, params));
+  // the lines on their way keep arriving while the active list is rolled back
+  PROFILE_HOST_SECTION(m_profiler, host_section::caches, m_processor_state.caches.step());
+}
+
+uint64_t simulator::fast_forward(const uint64_t max_instructions) {
+  if (!m_processor_state.threads.empty()) {
+    LOG_ERROR("Error: fast_forward called on a multithreaded machine\n");
+    return 0;
+  }
+
+  // check if the pipeline is idle, so that its state is the architectural one
+  if (m_processor_state.exception || !m_processor_state.active_list.empty() || !m_processor_state.decoded_pcs.empty()) {
+    LOG_ERROR("Error: fast_forward called with instructions in flight\n");
+    return 0;
+  }
+
+  functional_emulator emulator(get_program(), to_architectural_state(m_processor_state));
+  const uint64_t num_executed {emulator.run(max_instructions)};
+  m_processor_state = to_processor_state(emulator.get_state(), m_config);
+  if (m_checker) {
+    enable_cosim();
+  }
+  return num_executed;
+}
+
+void simulator::enable_cosim() {
+  if (!m_processor_state.threads.empty()) {
+    LOG_ERROR("Error: enable_cosim called on a multithreaded machine\n");
+    return;
+  }
+  m_checker = std::make_unique<cosim_checker>(get_program(), m_processor_state);
+  m_commit_unit.set_checker(m_checker.get());
+}
+
+void simulator::set_pipeline_recorder(pipeline_recorder* recorder) {
+  m_recorder = recorder;
+  m_decode_unit.set_recorder(recorder);
+  m_rename_unit.set_recorder(recorder);
+  m_issue_unit.set_recorder(recorder);
+  for (auto& alu_unit : m_alu_units) {
+    alu_unit.set_recorder(recorder);
+  }
+  m_load_store_unit.set_recorder(recorder);
+  m_forward_unit.set_recorder(recorder);
+  m_commit_unit.set_recorder(recorder);
+}
+
+void simulator::set_host_profiler(host_profiler* profiler) {
+  m_profiler = profiler;
+}
+
+void simulator::save_checkpoint(std::ostream& os) const {
+  if (!m_processor_state.threads.empty()) {
+    LOG_ERROR("Error: save_checkpoint called on a multithreaded machine\n");
+    return;
+  }
+  write_checkpoint(os, m_config, m_cycle, get_program(), m_processor_state);
+}
+
+simulator simulator::load_checkpoint(std::istream& is) {
+  checkpoint_t checkpoint {read_checkpoint(is)};
+  simulator sim(std::move(checkpoint.program), checkpoint.config);
+  sim.m_processor_state = std::move(checkpoint.state);
+  sim.m_cycle = checkpoint.cycle;
+  return sim;
 }
 
 json simulator::get_json_state() const {
-  return m_processor_state.to_json();
+  json state;
+  PROFILE_HOST_SECTION(m_profiler, host_section::serialize, state = m_processor_state.to_json());
+  return state;
 }
\ No newline at end of file
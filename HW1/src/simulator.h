@@ -3,32 +3,105 @@
 
 
 
+#include <istream>
+#include <memory>
+#include <ostream>
 #include <vector>
 #include "alu_unit.h"
 #include "commit_unit.h"
 #include "common.h"
+#include "cosim_checker.h"
 #include "decode_unit.h"
 #include "forward_unit.h"
+#include "host_profiler.h"
 #include "issue_unit.h"
+#include "load_store_unit.h"
+#include "machine_config.h"
+#include "pipeline_recorder.h"
 #include "processor_state.h"
 #include "rename_unit.h"
 
 
 class simulator {
 public:
-  explicit simulator(const program_t &program);
+  // decodes the program, throwing a program_error if it is malformed
+  explicit simulator(const program_t &program, const machine_config& config = {});
+  // throws a config_error if the machine parameters are out of bounds
+  explicit simulator(decoded_program_t program, const machine_config& config = {});
+  /* Runs every program on a hardware thread of a simultaneously
+   * multithreaded machine, which has a register map table, a program counter
+   * and an active list per thread and shares the rest. Throws a config_error
+   * if the physical registers cannot hold the maps of every thread.
+   */
+  simulator(std::vector<decoded_program_t> programs, const machine_config& config);
   bool can_step() const;
   void step();
+  /* Returns the number of cycles ahead in which no unit can make progress,
+   * i.e., in which stepping would only advance the cycle counter and count
+   * the stalls, until the next event of a multi-cycle unit. Rolling back an
+   * exception or a mispredicted branch is never idle.
+   */
+  uint64_t idle_cycles() const;
+  /* Advances through at most max_cycles idle cycles in one jump, leaving the
+   * same state and counters as stepping through them one by one. Returns the
+   * number of skipped cycles.
+   */
+  uint64_t skip_idle_cycles(uint64_t max_cycles = UINT64_MAX);
   json get_json_state() const;
+  const processor_state& get_state() const { return m_processor_state; }
+  // the data memory, which the multi-core machine keeps in sync with the other cores
+  data_memory& get_memory() { return m_processor_state.memory; }
+  const machine_config& get_config() const { return m_config; }
+  const decoded_program_t& get_program() const { return m_programs.front(); }
+  const std::vector<decoded_program_t>& get_programs() const { return m_programs; }
+  // number of cycles simulated since the start of the program
+  uint64_t get_cycle() const { return m_cycle; }
+  /* Executes at most max_instructions instructions on the functional
+   * emulator, then continues with an idle pipeline holding the resulting
+   * architectural state. Only an idle pipeline of a single thread can be
+   * fast-forwarded, i.e., at the start of the program. Returns the number of
+   * executed instructions.
+   */
+  uint64_t fast_forward(uint64_t max_instructions);
+  /* Checks every committed instruction of a single thread against the
+   * functional emulator from now on, throwing a cosim_error at the first
+   * mismatch.
+   */
+  void enable_cosim();
+  // streams the lifecycle of every instruction to the recorder from now on, or stops if it is nullptr
+  void set_pipeline_recorder(pipeline_recorder* recorder);
+  // measures the host time of every unit and of get_json_state from now on, or stops if it is nullptr
+  void set_host_profiler(host_profiler* profiler);
+  host_profiler* get_host_profiler() const { return m_profiler; }
+  // writes a checkpoint of a single thread from which load_checkpoint resumes the simulation exactly
+  void save_checkpoint(std::ostream& os) const;
+  // throws a format_error if the checkpoint is malformed
+  static simulator load_checkpoint(std::istream& is);
 private:
+  template <typename params_t>
   void normal_step();
+  template <typename params_t>
   void exception_step();
-  program_t m_program;
+  // steps the units of a simultaneously multithreaded machine, which never leaves its normal mode
+  template <typename params_t>
+  void smt_step();
+  // returns true if the given hardware thread has instructions left to run or roll back
+  bool can_step_thread(uint32_t id) const;
+  std::vector<decoded_program_t> m_programs;
+  machine_config m_config;
+  uint64_t m_cycle {0};
+  // the steps of the units specialized for the configuration, selected once at construction
+  void (simulator::*m_normal_step)() {};
+  void (simulator::*m_exception_step)() {};
   processor_state m_processor_state;
+  std::unique_ptr<cosim_checker> m_checker;
+  pipeline_recorder* m_recorder {nullptr};
+  host_profiler* m_profiler {nullptr};
   decode_unit m_decode_unit;
   rename_unit m_rename_unit;
   issue_unit m_issue_unit;
   std::vector<alu_unit> m_alu_units;
+  load_store_unit m_load_store_unit;
   forward_unit m_forward_unit;
   commit_unit m_commit_unit;
 };
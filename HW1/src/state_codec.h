@@ -0,0 +1,212 @@
+#ifndef STATE_CODEC_H
+#define STATE_CODEC_H
+
+
+
+#include <cstdint>
+#include "binary_io.h"
+#include "common.h"
+
+/* Binary encoding of the elements of the processor state, shared by the
+ * binary trace and the checkpoints. Registers, PCs, values and busy bits are
+ * plain variable-length integers, and the entries of the pipeline structures
+ * are a byte of flags followed by their fields.
+ */
+inline void write_element(byte_writer& writer, const uint64_t value) {
+  writer.write_varint(value);
+}
+
+inline void write_element(byte_writer& writer, const active_list_entry_t& entry) {
+  writer.write_u8(static_cast<uint8_t>(entry.done | entry.exception << 1));
+  writer.write_varint(entry.logical_destination);
+  writer.write_varint(entry.old_destination);
+  writer.write_varint(entry.pc);
+}
+
+inline void write_element(byte_writer& writer, const integer_queue_entry_t& entry) {
+  writer.write_u8(static_cast<uint8_t>(entry.op_a_is_ready | entry.op_b_is_ready << 1));
+  writer.write_varint(static_cast<uint64_t>(entry.op));
+  writer.write_varint(entry.dest_register);
+  writer.write_varint(entry.op_a_reg_tag);
+  writer.write_varint(entry.op_a_value);
+  writer.write_varint(entry.op_b_reg_tag);
+  writer.write_varint(entry.op_b_value);
+  writer.write_varint(entry.pc);
+}
+
+inline void write_element(byte_writer& writer, const alu_queue_entry_t& entry) {
+  writer.write_varint(static_cast<uint64_t>(entry.op));
+  writer.write_varint(entry.dest_register);
+  writer.write_varint(entry.op_a_value);
+  writer.write_varint(entry.op_b_value);
+  writer.write_varint(entry.pc);
+}
+
+inline void write_element(byte_writer& writer, const alu_result_t& entry) {
+  writer.write_u8(static_cast<uint8_t>(entry.exception));
+  writer.write_varint(entry.dest_register);
+  writer.write_varint(entry.result);
+  writer.write_varint(entry.pc);
+}
+
+inline void write_element(byte_writer& writer, const load_store_queue_entry_t& entry) {
+  writer.write_u8(static_cast<uint8_t>(entry.base_is_ready | entry.data_is_ready << 1 | entry.address_is_known << 2
+    | entry.done << 3));
+  writer.write_varint(static_cast<uint64_t>(entry.op));
+  writer.write_varint(entry.dest_register);
+  writer.write_varint(entry.base_reg_tag);
+  writer.write_varint(entry.base_value);
+  writer.write_varint(entry.data_reg_tag);
+  writer.write_varint(entry.data_value);
+  writer.write_varint(entry.offset);
+  writer.write_varint(entry.address);
+  writer.write_varint(entry.pc);
+}
+
+inline void write_element(byte_writer& writer, const alu_stage_t& stage) {
+  write_element(writer, stage.result);
+  writer.write_varint(stage.cycles_left);
+}
+
+inline void write_element(byte_writer& writer, const mshr_t& mshr) {
+  writer.write_varint(mshr.line);
+  writer.write_varint(mshr.cycles_left);
+}
+
+inline void write_element(byte_writer& writer, const branch_queue_entry_t& entry) {
+  writer.write_u8(static_cast<uint8_t>(entry.predicted_taken | entry.is_renamed << 1 | entry.taken << 2));
+  writer.write_varint(entry.pc);
+  writer.write_varint(entry.target);
+  writer.write_varint(entry.history);
+  writer.write_varint(entry.fetch_cycle);
+  writer.write_varint(entry.dest_register);
+}
+
+inline void write_element(byte_writer& writer, const tage_entry_t& entry) {
+  writer.write_varint(entry.tag);
+  writer.write_varint(entry.counter);
+  writer.write_varint(entry.useful);
+}
+
+inline void write_element(byte_writer& writer, const map_checkpoint_t& checkpoint) {
+  writer.write_varint(checkpoint.pc);
+  writer.write_varint(checkpoint.dest_register);
+  for (const reg_t reg : checkpoint.register_map_table) {
+    writer.write_varint(reg);
+  }
+}
+
+inline void write_element(byte_writer& writer, const instruction_t& instruction) {
+  writer.write_varint(static_cast<uint64_t>(instruction.op));
+  writer.write_varint(instruction.dest);
+  writer.write_varint(instruction.op_a);
+  writer.write_varint(instruction.op_b);
+  writer.write_varint(instruction.imm);
+}
+
+template <typename value_t>
+void read_element(byte_reader& reader, value_t& value) {
+  value = static_cast<value_t>(reader.read_varint());
+}
+
+inline void read_element(byte_reader& reader, active_list_entry_t& entry) {
+  const uint8_t flags {reader.read_u8()};
+  entry.done = flags & 1;
+  entry.exception = flags & 2;
+  entry.logical_destination = static_cast<reg_t>(reader.read_varint());
+  entry.old_destination = static_cast<reg_t>(reader.read_varint());
+  entry.pc = static_cast<pc_t>(reader.read_varint());
+}
+
+inline void read_element(byte_reader& reader, integer_queue_entry_t& entry) {
+  const uint8_t flags {reader.read_u8()};
+  entry.op_a_is_ready = flags & 1;
+  entry.op_b_is_ready = flags & 2;
+  entry.op = static_cast<opcode>(reader.read_varint());
+  entry.dest_register = static_cast<reg_t>(reader.read_varint());
+  entry.op_a_reg_tag = static_cast<reg_t>(reader.read_varint());
+  entry.op_a_value = reader.read_varint();
+  entry.op_b_reg_tag = static_cast<reg_t>(reader.read_varint());
+  entry.op_b_value = reader.read_varint();
+  entry.pc = static_cast<pc_t>(reader.read_varint());
+}
+
+inline void read_element(byte_reader& reader, alu_queue_entry_t& entry) {
+  entry.op = static_cast<opcode>(reader.read_varint());
+  entry.dest_register = static_cast<reg_t>(reader.read_varint());
+  entry.op_a_value = reader.read_varint();
+  entry.op_b_value = reader.read_varint();
+  entry.pc = static_cast<pc_t>(reader.read_varint());
+}
+
+inline void read_element(byte_reader& reader, alu_result_t& entry) {
+  entry.exception = reader.read_u8() & 1;
+  entry.dest_register = static_cast<reg_t>(reader.read_varint());
+  entry.result = reader.read_varint();
+  entry.pc = static_cast<pc_t>(reader.read_varint());
+}
+
+inline void read_element(byte_reader& reader, load_store_queue_entry_t& entry) {
+  const uint8_t flags {reader.read_u8()};
+  entry.base_is_ready = flags & 1;
+  entry.data_is_ready = flags & 2;
+  entry.address_is_known = flags & 4;
+  entry.done = flags & 8;
+  entry.op = static_cast<opcode>(reader.read_varint());
+  entry.dest_register = static_cast<reg_t>(reader.read_varint());
+  entry.base_reg_tag = static_cast<reg_t>(reader.read_varint());
+  entry.base_value = reader.read_varint();
+  entry.data_reg_tag = static_cast<reg_t>(reader.read_varint());
+  entry.data_value = reader.read_varint();
+  entry.offset = reader.read_varint();
+  entry.address = reader.read_varint();
+  entry.pc = static_cast<pc_t>(reader.read_varint());
+}
+
+inline void read_element(byte_reader& reader, alu_stage_t& stage) {
+  read_element(reader, stage.result);
+  stage.cycles_left = static_cast<uint32_t>(reader.read_varint());
+}
+
+inline void read_element(byte_reader& reader, mshr_t& mshr) {
+  mshr.line = reader.read_varint();
+  mshr.cycles_left = static_cast<uint32_t>(reader.read_varint());
+}
+
+inline void read_element(byte_reader& reader, branch_queue_entry_t& entry) {
+  const uint8_t flags {reader.read_u8()};
+  entry.predicted_taken = flags & 1;
+  entry.is_renamed = flags & 2;
+  entry.taken = flags & 4;
+  entry.pc = static_cast<pc_t>(reader.read_varint());
+  entry.target = static_cast<pc_t>(reader.read_varint());
+  entry.history = reader.read_varint();
+  entry.fetch_cycle = reader.read_varint();
+  entry.dest_register = static_cast<reg_t>(reader.read_varint());
+}
+
+inline void read_element(byte_reader& reader, tage_entry_t& entry) {
+  entry.tag = static_cast<uint16_t>(reader.read_varint());
+  entry.counter = static_cast<uint8_t>(reader.read_varint());
+  entry.useful = static_cast<uint8_t>(reader.read_varint());
+}
+
+inline void read_element(byte_reader& reader, map_checkpoint_t& checkpoint) {
+  checkpoint.pc = static_cast<pc_t>(reader.read_varint());
+  checkpoint.dest_register = static_cast<reg_t>(reader.read_varint());
+  for (reg_t& reg : checkpoint.register_map_table) {
+    reg = static_cast<reg_t>(reader.read_varint());
+  }
+}
+
+inline void read_element(byte_reader& reader, instruction_t& instruction) {
+  instruction.op = static_cast<opcode>(reader.read_varint());
+  instruction.dest = static_cast<uint32_t>(reader.read_varint());
+  instruction.op_a = static_cast<uint32_t>(reader.read_varint());
+  instruction.op_b = static_cast<uint32_t>(reader.read_varint());
+  instruction.imm = reader.read_varint();
+}
+
+
+
+#endif //STATE_CODEC_H
@@ -0,0 +1,200 @@
+#include "state_serializer.h"
+
+#include <charconv>
+
+void json_state_serializer::write_indent(const uint32_t depth) {
+  m_buffer.append(4 * depth, ' ');
+}
+
+void json_state_serializer::write_key(const uint32_t depth, const char* key) {
+  write_indent(depth);
+  m_buffer += '"';
+  m_buffer += key;
+  m_buffer += "\": ";
+}
+
+void json_state_serializer::write_uint(const uint64_t value) {
+  char digits[20];
+  auto [end, error] = std::to_chars(std::begin(digits), std::end(digits), value);
+  m_buffer.append(digits, end);
+}
+
+void json_state_serializer::write_bool(const bool value) {
+  m_buffer += value ? "true" : "false";
+}
+
+void json_state_serializer::write_string(const char* value) {
+  m_buffer += '"';
+  m_buffer += value;
+  m_buffer += '"';
+}
+
+/* Writes a JSON array in the layout of nlohmann::json::dump: empty arrays are
+ * written as "[]", other arrays have one element per line at depth + 1.
+ */
+template <typename container_t, typename element_writer_t>
+void json_state_serializer::write_array(const uint32_t depth, const container_t& container, element_writer_t write_element) {
+  if (container.empty()) {
+    m_buffer += "[]";
+    return;
+  }
+
+  m_buffer += "[\n";
+  bool first {true};
+  for (const auto& element : container) {
+    if (!first) {
+      m_buffer += ",\n";
+    }
+    first = false;
+    write_indent(depth + 1);
+    write_element(element, depth + 1);
+  }
+  m_buffer += '\n';
+  write_indent(depth);
+  m_buffer += ']';
+}
+
+void json_state_serializer::write_active_list(const uint32_t depth, const thread_state_t& thread) {
+  write_key(depth, "ActiveList");
+  write_array(depth, thread.active_list, [this](const active_list_entry_t& entry, const uint32_t entry_depth) {
+    m_buffer += "{\n";
+    write_key(entry_depth + 1, "Done");
+    write_bool(entry.done);
+    m_buffer += ",\n";
+    write_key(entry_depth + 1, "Exception");
+    write_bool(entry.exception);
+    m_buffer += ",\n";
+    write_key(entry_depth + 1, "LogicalDestination");
+    write_uint(entry.logical_destination);
+    m_buffer += ",\n";
+    write_key(entry_depth + 1, "OldDestination");
+    write_uint(entry.old_destination);
+    m_buffer += ",\n";
+    write_key(entry_depth + 1, "PC");
+    write_uint(entry.pc);
+    m_buffer += '\n';
+    write_indent(entry_depth);
+    m_buffer += '}';
+  });
+}
+
+void json_state_serializer::write_decoded_pcs(const uint32_t depth, const thread_state_t& thread) {
+  write_key(depth, "DecodedPCs");
+  write_array(depth, thread.decoded_pcs, [this](const std::pair<pc_t, instruction_t>& entry, uint32_t) {
+    write_uint(entry.first);
+  });
+}
+
+void json_state_serializer::write_exception(const uint32_t depth, const thread_state_t& thread) {
+  write_key(depth, "Exception");
+  write_bool(thread.exception);
+  m_buffer += ",\n";
+  write_key(depth, "ExceptionPC");
+  write_uint(thread.exception_pc);
+}
+
+void json_state_serializer::write_free_list(const uint32_t depth, const processor_state& state) {
+  write_key(depth, "FreeList");
+  write_array(depth, state.free_list, [this](const reg_t reg, uint32_t) { write_uint(reg); });
+}
+
+void json_state_serializer::write_integer_queue(const uint32_t depth, const processor_state& state) {
+  write_key(depth, "IntegerQueue");
+  write_array(depth, state.integer_queue.in_age_order(), [this](const integer_queue_entry_t& entry, const uint32_t entry_depth) {
+    m_buffer += "{\n";
+    write_key(entry_depth + 1, "DestRegister");
+    write_uint(entry.dest_register);
+    m_buffer += ",\n";
+    write_key(entry_depth + 1, "OpAIsReady");
+    write_bool(entry.op_a_is_ready);
+    m_buffer += ",\n";
+    write_key(entry_depth + 1, "OpARegTag");
+    write_uint(entry.op_a_reg_tag);
+    m_buffer += ",\n";
+    write_key(entry_depth + 1, "OpAValue");
+    write_uint(entry.op_a_value);
+    m_buffer += ",\n";
+    write_key(entry_depth + 1, "OpBIsReady");
+    write_bool(entry.op_b_is_ready);
+    m_buffer += ",\n";
+    write_key(entry_depth + 1, "OpBRegTag");
+    write_uint(entry.op_b_reg_tag);
+    m_buffer += ",\n";
+    write_key(entry_depth + 1, "OpBValue");
+    write_uint(entry.op_b_value);
+    m_buffer += ",\n";
+    write_key(entry_depth + 1, "OpCode");
+    write_string(opcode_to_string(entry.op));
+    m_buffer += ",\n";
+    write_key(entry_depth + 1, "PC");
+    write_uint(entry.pc);
+    m_buffer += '\n';
+    write_indent(entry_depth);
+    m_buffer += '}';
+  });
+}
+
+void json_state_serializer::write_register_map_table(const uint32_t depth, const thread_state_t& thread) {
+  write_key(depth, "RegisterMapTable");
+  write_array(depth, thread.register_map_table, [this](const reg_t reg, uint32_t) { write_uint(reg); });
+}
+
+const std::string& json_state_serializer::serialize(const processor_state& state, const uint32_t depth) {
+  m_buffer.clear();
+
+  // keys are written in the sorted order used by nlohmann::json objects, the fields of the threads interleaved
+  const uint32_t field_depth {depth + 1};
+  const bool single_thread {state.threads.empty()};
+  m_buffer += "{\n";
+  if (single_thread) {
+    write_active_list(field_depth, state);
+    m_buffer += ",\n";
+  }
+  write_key(field_depth, "BusyBitTable");
+  write_array(field_depth, state.busy_bit_table, [this](const bool busy, uint32_t) { write_bool(busy); });
+  m_buffer += ",\n";
+  if (single_thread) {
+    write_decoded_pcs(field_depth, state);
+    m_buffer += ",\n";
+    write_exception(field_depth, state);
+    m_buffer += ",\n";
+  }
+  write_free_list(field_depth, state);
+  m_buffer += ",\n";
+  write_integer_queue(field_depth, state);
+  m_buffer += ",\n";
+  if (single_thread) {
+    write_key(field_depth, "PC");
+    write_uint(state.pc);
+    m_buffer += ",\n";
+  }
+  write_key(field_depth, "PhysicalRegisterFile");
+  write_array(field_depth, state.physical_register_file, [this](const uint64_t value, uint32_t) { write_uint(value); });
+  m_buffer += ",\n";
+  if (single_thread) {
+    write_register_map_table(field_depth, state);
+  } else {
+    write_key(field_depth, "Threads");
+    write_array(field_depth, state.threads, [this](const thread_state_t& thread, const uint32_t thread_depth) {
+      m_buffer += "{\n";
+      write_active_list(thread_depth + 1, thread);
+      m_buffer += ",\n";
+      write_decoded_pcs(thread_depth + 1, thread);
+      m_buffer += ",\n";
+      write_exception(thread_depth + 1, thread);
+      m_buffer += ",\n";
+      write_key(thread_depth + 1, "PC");
+      write_uint(thread.pc);
+      m_buffer += ",\n";
+      write_register_map_table(thread_depth + 1, thread);
+      m_buffer += '\n';
+      write_indent(thread_depth);
+      m_buffer += '}';
+    });
+  }
+  m_buffer += '\n';
+  write_indent(depth);
+  m_buffer += '}';
+
+  return m_buffer;
+}
@@ -0,0 +1,38 @@
+#ifndef STATE_SERIALIZER_H
+#define STATE_SERIALIZER_H
+
+
+
+#include <string>
+#include "processor_state.h"
+
+/* Serializes a processor state straight into a reusable text buffer, without
+ * building the intermediate nlohmann DOM. The output is identical to
+ * processor_state::to_json().dump(4) nested at the given depth, i.e., with
+ * every line after the first indented by 4 * depth spaces. The buffer keeps
+ * its capacity between calls, so serializing does not allocate once warm.
+ */
+class json_state_serializer {
+public:
+  const std::string& serialize(const processor_state& state, uint32_t depth = 0);
+private:
+  void write_indent(uint32_t depth);
+  void write_key(uint32_t depth, const char* key);
+  void write_uint(uint64_t value);
+  void write_bool(bool value);
+  void write_string(const char* value);
+  // the fields of a state, each with its key
+  void write_active_list(uint32_t depth, const thread_state_t& thread);
+  void write_decoded_pcs(uint32_t depth, const thread_state_t& thread);
+  void write_exception(uint32_t depth, const thread_state_t& thread); // and the exception pc
+  void write_free_list(uint32_t depth, const processor_state& state);
+  void write_integer_queue(uint32_t depth, const processor_state& state);
+  void write_register_map_table(uint32_t depth, const thread_state_t& thread);
+  template <typename container_t, typename element_writer_t>
+  void write_array(uint32_t depth, const container_t& container, element_writer_t write_element);
+  std::string m_buffer;
+};
+
+
+
+#endif //STATE_SERIALIZER_H
@@ -0,0 +1,22 @@
+#include "trace_writer.h"
+
+// indentation of an element nested in the top-level array
+static constexpr char element_indent[] {"    "};
+
+void json_trace_writer::write(const processor_state& state) {
+  // open the array or separate from the previous element
+  m_os << (m_num_states == 0 ? "[\n" : ",\n") << element_indent;
+
+  // the state is nested one level deep in the array
+  const std::string& serialized {m_serializer.serialize(state, 1)};
+  m_os.write(serialized.data(), static_cast<std::streamsize>(serialized.size()));
+  m_num_states++;
+}
+
+void json_trace_writer::close() {
+  if (m_closed) {
+    return;
+  }
+  m_os << (m_num_states == 0 ? "[]" : "\n]") << std::endl;
+  m_closed = true;
+}
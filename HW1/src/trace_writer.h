@@ -0,0 +1,38 @@
+#ifndef TRACE_WRITER_H
+#define TRACE_WRITER_H
+
+
+
+#include <ostream>
+#include "processor_state.h"
+#include "state_serializer.h"
+
+// destination of the per-cycle processor states produced by a simulation
+class trace_writer {
+public:
+  virtual ~trace_writer() = default;
+  virtual void write(const processor_state& state) = 0;
+  virtual void close() = 0;
+};
+
+/* Streams the per-cycle processor states to an output stream as a JSON array.
+ * Each state is written as soon as it is produced, so memory stays bounded
+ * regardless of the number of simulated cycles. The output is identical to
+ * dumping the whole array with an indentation of 4 spaces.
+ */
+class json_trace_writer : public trace_writer {
+public:
+  explicit json_trace_writer(std::ostream& os)
+    : m_os(os) {}
+  void write(const processor_state& state) override;
+  void close() override;
+private:
+  std::ostream& m_os;
+  json_state_serializer m_serializer;
+  uint64_t m_num_states {0};
+  bool m_closed {false};
+};
+
+
+
+#endif //TRACE_WRITER_H
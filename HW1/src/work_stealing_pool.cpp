@@ -0,0 +1,105 @@
+#include "work_stealing_pool.h"
+
+#include <algorithm>
+
+work_stealing_pool::work_stealing_pool(uint32_t num_threads) {
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (uint32_t i {0}; i < num_threads; ++i) {
+    m_queues.push_back(std::make_unique<worker_queue_t>());
+  }
+  for (uint32_t i {0}; i < num_threads; ++i) {
+    m_threads.emplace_back(&work_stealing_pool::run_worker, this, i);
+  }
+}
+
+work_stealing_pool::~work_stealing_pool() {
+  wait();
+  {
+    std::lock_guard<std::mutex> lock {m_mutex};
+    m_stopping = true;
+  }
+  m_work_available.notify_all();
+  for (auto& thread : m_threads) {
+    thread.join();
+  }
+}
+
+void work_stealing_pool::submit(task_t task) {
+  uint32_t queue_id {0};
+  {
+    std::lock_guard<std::mutex> lock {m_mutex};
+    queue_id = m_next_queue;
+    m_next_queue = (m_next_queue + 1) % m_queues.size();
+    m_num_unfinished++;
+  }
+
+  // the task is queued before it is counted, so a worker woken up for it always finds it
+  {
+    std::lock_guard<std::mutex> lock {m_queues[queue_id]->mutex};
+    m_queues[queue_id]->tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock {m_mutex};
+    m_num_queued++;
+  }
+  m_work_available.notify_one();
+}
+
+void work_stealing_pool::wait() {
+  std::unique_lock<std::mutex> lock {m_mutex};
+  m_all_done.wait(lock, [this] { return m_num_unfinished == 0; });
+}
+
+bool work_stealing_pool::take_task(const uint32_t worker_id, task_t& task) {
+  // check the own queue first, taking the most recent task
+  {
+    worker_queue_t& queue {*m_queues[worker_id]};
+    std::lock_guard<std::mutex> lock {queue.mutex};
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+      return true;
+    }
+  }
+
+  // steal the oldest task of the other queues, starting from the next worker
+  for (uint32_t offset {1}; offset < m_queues.size(); ++offset) {
+    worker_queue_t& queue {*m_queues[(worker_id + offset) % m_queues.size()]};
+    std::lock_guard<std::mutex> lock {queue.mutex};
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void work_stealing_pool::run_worker(const uint32_t worker_id) {
+  while (true) {
+    // sleep until a task is queued, or the pool stops
+    {
+      std::unique_lock<std::mutex> lock {m_mutex};
+      m_work_available.wait(lock, [this] { return m_stopping || m_num_queued > 0; });
+      if (m_num_queued == 0) {
+        return;
+      }
+      // claim a queued task, which take_task is then guaranteed to find
+      m_num_queued--;
+    }
+
+    task_t task;
+    while (!take_task(worker_id, task)) {
+      // there is a queued task for every claim, but the scan can race with the other workers
+      std::this_thread::yield();
+    }
+    task();
+
+    std::lock_guard<std::mutex> lock {m_mutex};
+    if (--m_num_unfinished == 0) {
+      m_all_done.notify_all();
+    }
+  }
+}
@@ -0,0 +1,59 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Fixed set of worker threads running independent tasks. Every worker owns a
+ * queue: tasks are submitted round-robin to the queues, a worker takes the
+ * most recent task of its own queue, and an idle worker steals the oldest task
+ * of another queue. Long tasks therefore do not hold back the short tasks
+ * queued behind them. Tasks must not throw.
+ */
+class work_stealing_pool {
+public:
+  typedef std::function<void()> task_t;
+
+  // starts the workers, using one per hardware thread if num_threads is 0
+  explicit work_stealing_pool(uint32_t num_threads = 0);
+  // waits for the submitted tasks, then stops the workers
+  ~work_stealing_pool();
+  work_stealing_pool(const work_stealing_pool&) = delete;
+  work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+  uint32_t num_threads() const { return static_cast<uint32_t>(m_threads.size()); }
+  void submit(task_t task);
+  // blocks until every submitted task has finished
+  void wait();
+private:
+  struct worker_queue_t {
+    std::mutex mutex;
+    std::deque<task_t> tasks;
+  };
+
+  void run_worker(uint32_t worker_id);
+  bool take_task(uint32_t worker_id, task_t& task);
+
+  std::vector<std::unique_ptr<worker_queue_t>> m_queues;
+  std::vector<std::thread> m_threads;
+  // guards the counters below, which the workers sleep on when every queue is empty
+  std::mutex m_mutex;
+  std::condition_variable m_work_available;
+  std::condition_variable m_all_done;
+  uint64_t m_num_queued {0};
+  uint64_t m_num_unfinished {0};
+  uint32_t m_next_queue {0};
+  bool m_stopping {false};
+};
+
+
+
+#endif //WORK_STEALING_POOL_H
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+import argparse
+import glob
+import json
+import os
+import subprocess
+import tempfile
+
+RED = '\x1b[31m'
+GREEN = '\x1b[36m'
+RESET = '\x1b[0m'
+
+
+parser = argparse.ArgumentParser(description="Checks that the binary traces of the given tests expand back to their "
+                                 "reference JSON output with trace2json.")
+
+parser.add_argument("tests", nargs="*", help="The test directories, all of given_tests by default.")
+parser.add_argument("--simulator", "-s", default="build/simulate", help="The simulator binary.")
+parser.add_argument("--trace2json", "-t", default="build/trace2json", help="The trace2json binary.")
+
+args = parser.parse_args()
+
+
+def readOptions(test: str) -> list[str]:
+    path = os.path.join(test, "options.txt")
+    return open(path).read().split() if os.path.exists(path) else []
+
+
+def checkTest(test: str, directory: str) -> bool:
+    '''
+        @return true if the binary trace of the test expands to its reference output, as a whole and cycle by cycle
+    '''
+
+    options = readOptions(test)
+    # the multithreaded machine only writes the JSON output
+    if "--smt-thread" in options:
+        print(f"[Skipped] {test} runs several threads.")
+        return True
+
+    trace = os.path.join(directory, "trace.bin")
+    subprocess.run([args.simulator, *options, "--trace-format", "binary", os.path.join(test, "input.json"), trace],
+                   check=True)
+    reference = json.load(open(os.path.join(test, "output.json")))
+
+    output = os.path.join(directory, "output.json")
+    subprocess.run([args.trace2json, trace, output], check=True)
+    if json.load(open(output)) != reference:
+        print(f"[{RED}Error{RESET}] {test}: the expanded trace differs from the reference output.")
+        return False
+
+    for cycle in range(len(reference)):
+        subprocess.run([args.trace2json, "--cycle", str(cycle), trace, output], check=True)
+        if json.load(open(output)) != reference[cycle]:
+            print(f"[{RED}Error{RESET}] {test}: the state of cycle {cycle} differs from the reference output.")
+            return False
+
+    print(f"{GREEN}PASSED!{RESET} {test} expanded from {os.path.getsize(trace)} bytes.")
+    return True
+
+
+tests = args.tests if len(args.tests) > 0 else sorted(glob.glob("given_tests/*"))
+failed = 0
+for test in tests:
+    with tempfile.TemporaryDirectory() as directory:
+        if checkTest(test, directory) == False:
+            failed += 1
+
+exit(1 if failed > 0 else 0)
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+import argparse
+import glob
+import json
+import os
+import subprocess
+import tempfile
+
+RED = '\x1b[31m'
+GREEN = '\x1b[36m'
+RESET = '\x1b[0m'
+
+
+parser = argparse.ArgumentParser(description="Checks that the simulations resumed from checkpoints write the same "
+                                 "trace and statistics as the uninterrupted simulations of the given tests.")
+
+parser.add_argument("tests", nargs="*", help="The test directories, all of given_tests by default.")
+parser.add_argument("--every", "-e", type=int, default=3, help="The cycles between two checkpoints.")
+parser.add_argument("--simulator", "-s", default="build/simulate", help="The simulator binary.")
+
+args = parser.parse_args()
+
+
+def readOptions(test: str) -> list[str]:
+    path = os.path.join(test, "options.txt")
+    return open(path).read().split() if os.path.exists(path) else []
+
+
+def checkTest(test: str, directory: str) -> bool:
+    '''
+        @return true if every checkpoint of the test resumes to the end of the uninterrupted trace
+    '''
+
+    options = readOptions(test)
+    # the multithreaded machine does not write checkpoints
+    if "--smt-thread" in options:
+        print(f"[Skipped] {test} runs several threads.")
+        return True
+
+    output = os.path.join(directory, "output.json")
+    subprocess.run([args.simulator, *options, "--stats", "--checkpoint-every", str(args.every),
+                    os.path.join(test, "input.json"), output], check=True)
+    full = json.load(open(output))
+    stats = json.load(open(output + ".stats.json"))
+
+    checkpoints = glob.glob(output + ".*.ckpt")
+    checkpoints.sort(key=lambda x: int(x.split(".")[-2]))
+    if len(checkpoints) == 0:
+        print(f"[{RED}Error{RESET}] {test} wrote no checkpoint.")
+        return False
+
+    resumed = os.path.join(directory, "resumed.json")
+    for checkpoint in checkpoints:
+        cycle = int(checkpoint.split(".")[-2])
+        subprocess.run([args.simulator, "--stats", "--resume", checkpoint, resumed], check=True)
+
+        # the resumed trace starts at the restored cycle
+        if json.load(open(resumed)) != full[cycle:]:
+            print(f"[{RED}Error{RESET}] {test}: the trace resumed at cycle {cycle} differs.")
+            return False
+
+        if json.load(open(resumed + ".stats.json")) != stats:
+            print(f"[{RED}Error{RESET}] {test}: the statistics resumed at cycle {cycle} differ.")
+            return False
+
+    print(f"{GREEN}PASSED!{RESET} {test} resumed from {len(checkpoints)} checkpoints.")
+    return True
+
+
+tests = args.tests if len(args.tests) > 0 else sorted(glob.glob("given_tests/*"))
+failed = 0
+for test in tests:
+    with tempfile.TemporaryDirectory() as directory:
+        if checkTest(test, directory) == False:
+            failed += 1
+
+exit(1 if failed > 0 else 0)
@@ -0,0 +1,59 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "binary_trace.h"
+#include "binary_io.h"
+#include "state_serializer.h"
+#include "trace_writer.h"
+
+/* Expands a binary trace written with --trace-format binary back to the JSON
+ * output of the simulator. With --cycle, only the state at the end of the
+ * given cycle is written, as a single JSON object.
+ */
+int main(int argc, char *argv[]) {
+  if (argc != 3 && !(argc == 5 && std::string {argv[1]} == "--cycle")) {
+    std::cerr << "Usage: " << argv[0] << " [--cycle <cycle>] <trace file> <output file>" << std::endl;
+    return 1;
+  }
+  const bool single_state {argc == 5};
+  const std::string trace_file_name {argv[argc - 2]};
+  const std::string output_file_name {argv[argc - 1]};
+
+  std::ifstream trace_file(trace_file_name, std::ios::binary);
+  if (!trace_file.is_open()) {
+    std::cerr << "Failed to open file: " << trace_file_name << std::endl;
+    return 1;
+  }
+  std::ofstream output_file(output_file_name);
+  if (!output_file.is_open()) {
+    std::cerr << "Failed to open file: " << output_file_name << std::endl;
+    return 1;
+  }
+
+  try {
+    binary_trace_reader reader(trace_file);
+    if (single_state) {
+      const uint64_t cycle {std::stoull(argv[2])};
+      if (cycle >= reader.num_states()) {
+        std::cerr << "Cycle out of range, the trace has " << reader.num_states() << " states" << std::endl;
+        return 1;
+      }
+      json_state_serializer serializer;
+      output_file << serializer.serialize(reader.read_state(cycle)) << std::endl;
+    } else {
+      json_trace_writer writer(output_file);
+      for (uint64_t i {0}; i < reader.num_states(); ++i) {
+        writer.write(reader.read_state(i));
+      }
+      writer.close();
+    }
+  } catch (const format_error& e) {
+    std::cerr << "Malformed trace " << trace_file_name << ": " << e.what() << std::endl;
+    return 1;
+  } catch (const std::invalid_argument&) {
+    std::cerr << "Invalid cycle: " << argv[2] << std::endl;
+    return 1;
+  }
+
+  return 0;
+}